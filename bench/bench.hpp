@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+
+namespace bench
+{
+  static constexpr int RUNS = 5;
+
+  // Runs given function a few times and returns the shortest time a single
+  // run took, in seconds.
+  template<class Function>
+  double
+  measure(Function function)
+  {
+    double best = 0;
+
+    for (int i = 0; i < RUNS; ++i)
+    {
+      const auto start = std::chrono::steady_clock::now();
+
+      function();
+
+      const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+      if (i == 0 || elapsed.count() < best)
+      {
+        best = elapsed.count();
+      }
+    }
+
+    return best;
+  }
+
+  inline void
+  report_throughput(const char* name, std::size_t bytes, double seconds)
+  {
+    std::cout << "  "
+              << name
+              << ": "
+              << static_cast<double>(bytes) / seconds / 1e9
+              << " GB/s"
+              << std::endl;
+  }
+
+  void
+  scan();
+
+  void
+  save();
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <iterator>
+#include <new>
+
+#include "../src/sheet.hpp"
+#include "./bench.hpp"
+
+// Count every allocation made by the benchmark program, so that the ones made
+// while saving can be reported.
+static std::atomic<std::size_t> allocations(0);
+
+void*
+operator new(std::size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (const auto pointer = std::malloc(size > 0 ? size : 1))
+  {
+    return pointer;
+  }
+
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void
+operator delete(void* pointer, std::size_t) noexcept
+{
+  std::free(pointer);
+}
+
+namespace bench
+{
+  static constexpr int SAVES = 10;
+
+  // Fills every cell of the sheet, mixing fields which are written as such
+  // with ones which need quoting and numbers which are written from their
+  // source.
+  static void
+  fill(struct sheet& sheet)
+  {
+    static const std::u32string inputs[] = {
+      U"Lorem ipsum dolor sit amet",
+      U"12345.678",
+      U"Hello, world",
+      U"She said \"hi\"",
+      U"x",
+      U"-42",
+      U"Consectetur adipiscing elit, sed do eiusmod tempor",
+    };
+    std::size_t i = 0;
+
+    for (int y = 0; y < coordinates::MAX_Y; ++y)
+    {
+      for (int x = 0; x < coordinates::MAX_X; ++x)
+      {
+        sheet.set({ x, y }, inputs[i++ % std::size(inputs)]);
+      }
+    }
+  }
+
+  template<class Function>
+  static void
+  save(
+    const char* name,
+    const std::filesystem::path& path,
+    std::size_t cells,
+    Function function
+  )
+  {
+    std::size_t count = 0;
+    const auto seconds = measure([&]()
+    {
+      const auto before = allocations.load();
+
+      for (int i = 0; i < SAVES; ++i)
+      {
+        if (!function())
+        {
+          std::cout << "  Unable to write " << path << std::endl;
+          std::exit(EXIT_FAILURE);
+        }
+      }
+      count = allocations.load() - before;
+    });
+
+    report_throughput(name, std::filesystem::file_size(path) * SAVES, seconds);
+    std::cout << "    allocations: "
+              << count / SAVES
+              << " per save, "
+              << static_cast<double>(count) / SAVES / cells
+              << " per cell"
+              << std::endl;
+  }
+
+  void
+  save()
+  {
+    const auto path = std::filesystem::temp_directory_path()
+      / "levite-bench.csv";
+    const std::size_t cells = coordinates::MAX_X * coordinates::MAX_Y;
+    struct sheet sheet;
+
+    fill(sheet);
+
+    const auto snapshot = sheet.take_snapshot(path);
+
+    std::cout << "Saving " << cells << " cells:" << std::endl;
+    // Whole save, including taking the snapshot of the sheet.
+    save("save", path, cells, [&]()
+    {
+      return sheet.save(path, ',');
+    });
+    // Just formatting the rows and writing them into the file.
+    save("write", path, cells, [&]()
+    {
+      return sheet.save(snapshot, path, ',', nullptr, nullptr);
+    });
+    std::filesystem::remove(path);
+  }
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../src/scan.hpp"
+#include "./bench.hpp"
+
+namespace bench
+{
+  static constexpr std::size_t INPUT_SIZE = 64 << 20;
+  static constexpr char SEPARATOR = ',';
+
+  // Generates CSV input with unquoted fields of given length range, for
+  // looking at how the scanners do on both narrow and wide columns.
+  static std::string
+  generate(std::size_t min_length, std::size_t max_length)
+  {
+    static const char letters[] = "abcdefghijklmnopqrstuvwxyz 0123456789";
+    std::mt19937 random(min_length);
+    std::uniform_int_distribution<std::size_t> length(min_length, max_length);
+    std::uniform_int_distribution<std::size_t> letter(0, sizeof(letters) - 2);
+    std::string result;
+    int column = 0;
+
+    result.reserve(INPUT_SIZE + max_length + 1);
+    while (result.length() < INPUT_SIZE)
+    {
+      for (auto n = length(random); n > 0; --n)
+      {
+        result.append(1, letters[letter(random)]);
+      }
+      if (++column == 10)
+      {
+        result.append(1, '\n');
+        column = 0;
+      } else {
+        result.append(1, SEPARATOR);
+      }
+    }
+
+    return result;
+  }
+
+  static std::vector<std::string_view>
+  split_fields(const std::string& input)
+  {
+    std::vector<std::string_view> result;
+    std::size_t start = 0;
+
+    for (std::size_t i = 0; i < input.length(); ++i)
+    {
+      if (input[i] == SEPARATOR || input[i] == '\n')
+      {
+        result.push_back(std::string_view(input).substr(start, i - start));
+        start = i + 1;
+      }
+    }
+
+    return result;
+  }
+
+  // Loop which the tokenizer used for finding the end of an unquoted field
+  // before scan::find_special() replaced it.
+  static const char*
+  find_special_loop(const char* begin, const char* end, char separator)
+  {
+    while (
+      begin < end &&
+      *begin != separator &&
+      *begin != '\n' &&
+      *begin != '\r'
+    )
+    {
+      ++begin;
+    }
+
+    return begin;
+  }
+
+  // Test which the writer used for deciding whether a field needs quoting
+  // before scan::needs_quoting() replaced it.
+  static bool
+  needs_quoting_find(const std::string_view& input, char separator)
+  {
+    return (
+      input.find(separator) != std::string_view::npos ||
+      input.find('"') != std::string_view::npos ||
+      input.find('\n') != std::string_view::npos ||
+      input.find('\r') != std::string_view::npos
+    );
+  }
+
+  template<class Function>
+  static void
+  tokenize(const char* name, const std::string& input, Function function)
+  {
+    const auto begin = input.data();
+    const auto end = begin + input.length();
+    std::size_t count = 0;
+    const auto seconds = measure([&]()
+    {
+      count = 0;
+      for (
+        auto pos = begin;
+        (pos = function(pos, end, SEPARATOR)) < end;
+        ++pos
+      )
+      {
+        ++count;
+      }
+    });
+
+    if (count == 0)
+    {
+      std::cout << "  " << name << ": no fields found" << std::endl;
+      return;
+    }
+    report_throughput(name, input.length(), seconds);
+  }
+
+  template<class Function>
+  static void
+  quote(
+    const char* name,
+    const std::vector<std::string_view>& fields,
+    std::size_t bytes,
+    Function function
+  )
+  {
+    std::size_t count = 0;
+    const auto seconds = measure([&]()
+    {
+      count = 0;
+      for (const auto& field : fields)
+      {
+        count += function(field, SEPARATOR);
+      }
+    });
+
+    if (count > 0)
+    {
+      std::cout << "  " << name << ": unexpected quoting" << std::endl;
+      return;
+    }
+    report_throughput(name, bytes, seconds);
+  }
+
+  static void
+  scan(const char* title, std::size_t min_length, std::size_t max_length)
+  {
+    const auto input = generate(min_length, max_length);
+    const auto fields = split_fields(input);
+    std::size_t bytes = 0;
+
+    for (const auto& field : fields)
+    {
+      bytes += field.length();
+    }
+
+    std::cout << title << ", tokenizing:" << std::endl;
+    tokenize("loop", input, find_special_loop);
+    for (const auto& implementation : ::scan::implementations())
+    {
+      tokenize(implementation.name, input, implementation.find_special);
+    }
+    tokenize("find_special", input, ::scan::find_special);
+
+    std::cout << title << ", quoting:" << std::endl;
+    quote("find", fields, bytes, needs_quoting_find);
+    quote("needs_quoting", fields, bytes, ::scan::needs_quoting);
+  }
+
+  void
+  scan()
+  {
+    scan("Short fields", 1, 12);
+    scan("Long fields", 50, 400);
+  }
+}
@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <peelo/unicode/encoding/utf8.hpp>
+
+#include "./background.hpp"
+#include "./follow.hpp"
+#include "./screen.hpp"
+#include "./setting.hpp"
+#include "./workbook.hpp"
+
+namespace background
+{
+  // How often progress of a write is updated on the screen.
+  static constexpr int PROGRESS_TIMEOUT = 100;
+
+  // How often due automatic saves are checked for.
+  static constexpr int AUTOSAVE_TIMEOUT = 1000;
+
+  // How often followed files are checked for appended rows.
+  static constexpr int FOLLOW_TIMEOUT = 250;
+
+  // How often files of the sheets are checked for changes made by other
+  // programs.
+  static constexpr auto WATCH_INTERVAL = std::chrono::seconds(1);
+
+  struct job
+  {
+    struct sheet* sheet;
+    struct snapshot snapshot;
+    std::filesystem::path path;
+    char separator;
+    bool automatic;
+    std::vector<std::uint64_t> hashes;
+    std::atomic<int> progress;
+    std::atomic<bool> done;
+    bool result;
+    std::thread thread;
+  };
+
+  int autosave_interval = 0;
+
+  static std::unique_ptr<job> current;
+  static std::vector<struct sheet*> autosave_queue;
+  static auto last_autosave = std::chrono::steady_clock::now();
+  static auto last_watch = std::chrono::steady_clock::now();
+
+  bool
+  save(struct sheet& sheet, const std::filesystem::path& path, bool automatic)
+  {
+    if (current)
+    {
+      return false;
+    }
+
+    current = std::make_unique<job>();
+    current->sheet = &sheet;
+    current->snapshot = sheet.take_snapshot(path);
+    current->path = path;
+    current->separator = sheet.separator;
+    current->automatic = automatic;
+    current->progress = 0;
+    current->done = false;
+    current->result = false;
+    current->thread = std::thread([job = current.get()]()
+    {
+      job->result = sheet::save(
+        job->snapshot,
+        job->path,
+        job->separator,
+        &job->progress,
+        &job->hashes
+      );
+      job->done.store(true, std::memory_order_release);
+    });
+
+    return true;
+  }
+
+  static void
+  finish()
+  {
+    const auto job = std::move(current);
+
+    job->thread.join();
+    if (!job->result)
+    {
+      message = U"Error saving file.";
+      return;
+    }
+    job->sheet->saved(job->snapshot, job->path, std::move(job->hashes));
+    if (!job->automatic)
+    {
+      message = U"File saved.";
+    }
+  }
+
+  static void
+  follow(struct workbook& workbook, struct sheet& sheet)
+  {
+    const auto last_row = sheet.max_row - 1;
+
+    if (
+      sheet.continue_following() > 0 &&
+      &sheet == workbook.get_current().sheet.get() &&
+      setting::get_int(setting::key::follow_scroll) &&
+      cursor.y >= last_row
+    )
+    {
+      // Keep the cursor on the last row when it was already there.
+      move_to({ cursor.x, sheet.max_row - 1 });
+    }
+  }
+
+  static void
+  watch(struct workbook& workbook)
+  {
+    using peelo::unicode::encoding::utf8::decode;
+
+    for (auto& entry : workbook.entries)
+    {
+      auto& sheet = *entry.sheet;
+      int changed_rows;
+
+      if (
+        !entry.loaded ||
+        sheet.is_loading() ||
+        sheet.is_following() ||
+        !sheet.is_changed_on_disk()
+      )
+      {
+        continue;
+      }
+      // Unsaved changes are not thrown away, the user has to decide which
+      // version to keep.
+      if (sheet.modified)
+      {
+        std::error_code ec;
+
+        sheet.loaded_size = std::filesystem::file_size(*sheet.filename, ec);
+        sheet.loaded_time = std::filesystem::last_write_time(
+          *sheet.filename,
+          ec
+        );
+        message = sheet.filename->filename().u32string() +
+          U" has been changed by another program.";
+      }
+      else if (const auto error = sheet.reload(changed_rows))
+      {
+        message = *error;
+      }
+      else if (changed_rows > 0)
+      {
+        message = U"Reloaded " +
+          decode(std::to_string(changed_rows)) +
+          U" changed rows of " +
+          sheet.filename->filename().u32string() +
+          U".";
+      }
+    }
+  }
+
+  void
+  poll(struct workbook& workbook)
+  {
+    const auto now = std::chrono::steady_clock::now();
+
+    for (auto& entry : workbook.entries)
+    {
+      auto& sheet = *entry.sheet;
+
+      if (!entry.loaded)
+      {
+        continue;
+      }
+      sheet.continue_loading();
+      follow(workbook, sheet);
+      if (sheet.load_error)
+      {
+        message = *sheet.load_error;
+        sheet.load_error.reset();
+      }
+      sheet.recovery.flush(sheet.get_recovery_filename());
+    }
+
+    if (current)
+    {
+      if (!current->done.load(std::memory_order_acquire))
+      {
+        return;
+      }
+      finish();
+    }
+
+    // Files are not checked while they are being written.
+    if (
+      setting::get_int(setting::key::auto_reload) &&
+      now - last_watch >= WATCH_INTERVAL
+    )
+    {
+      last_watch = now;
+      watch(workbook);
+    }
+
+    if (
+      autosave_interval > 0 &&
+      autosave_queue.empty() &&
+      now - last_autosave >= std::chrono::seconds(autosave_interval)
+    )
+    {
+      last_autosave = now;
+      for (auto& entry : workbook.entries)
+      {
+        if (
+          entry.loaded &&
+          entry.sheet->modified &&
+          entry.sheet->filename &&
+          !entry.sheet->filter.is_partial()
+        )
+        {
+          autosave_queue.push_back(entry.sheet.get());
+        }
+      }
+    }
+
+    // Sheets are written one at a time.
+    if (!current && !autosave_queue.empty())
+    {
+      auto& sheet = *autosave_queue.front();
+
+      autosave_queue.erase(std::begin(autosave_queue));
+      if (sheet.modified && sheet.filename)
+      {
+        save(sheet, *sheet.filename, true);
+      }
+    }
+  }
+
+  void
+  wait()
+  {
+    if (current)
+    {
+      finish();
+    }
+  }
+
+  int
+  get_timeout(const struct workbook& workbook)
+  {
+    if (current || !autosave_queue.empty())
+    {
+      return PROGRESS_TIMEOUT;
+    }
+    for (const auto& entry : workbook.entries)
+    {
+      if (entry.loaded && entry.sheet->is_loading())
+      {
+        return PROGRESS_TIMEOUT;
+      }
+    }
+    for (const auto& entry : workbook.entries)
+    {
+      if (entry.loaded && entry.sheet->is_following())
+      {
+        return entry.sheet->following->backlog ? 0 : FOLLOW_TIMEOUT;
+      }
+    }
+    for (const auto& entry : workbook.entries)
+    {
+      if (entry.loaded && entry.sheet->recovery.is_pending())
+      {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+          recovery_log::SYNC_INTERVAL
+        ).count();
+      }
+    }
+    if (
+      autosave_interval > 0 ||
+      setting::get_int(setting::key::auto_reload)
+    )
+    {
+      return AUTOSAVE_TIMEOUT;
+    }
+
+    return -1;
+  }
+
+  std::optional<std::u32string>
+  get_status(const struct sheet& sheet)
+  {
+    using peelo::unicode::encoding::utf8::decode;
+
+    if (!current)
+    {
+      if (const auto progress = sheet.get_load_progress())
+      {
+        return U"Loading " +
+          sheet.filename->filename().u32string() +
+          U": " +
+          decode(std::to_string(*progress)) +
+          U"%";
+      }
+
+      return std::nullopt;
+    }
+
+    const auto total = current->snapshot.max_row;
+    const auto done = current->progress.load(std::memory_order_relaxed);
+    auto status = current->path.filename().u32string();
+
+    if (total > 0)
+    {
+      status += U": " + decode(std::to_string(done * 100 / total)) + U"%";
+    }
+
+    return (current->automatic ? U"Autosaving " : U"Writing ") + status;
+  }
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include "./sheet.hpp"
+
+// Writing of sheets into files on a background thread, so that the user
+// interface stays responsive while large sheets are being saved.
+namespace background
+{
+  // Number of seconds between automatic saves of modified sheets, or zero
+  // when automatic saving is disabled.
+  extern int autosave_interval;
+
+  // Starts writing a snapshot of given sheet into given file. Returns false
+  // if another write is already in progress.
+  bool
+  save(
+    struct sheet& sheet,
+    const std::filesystem::path& path,
+    bool automatic = false
+  );
+
+  // Finishes a write that has completed, starts automatic saves that are
+  // due, stores rows appended to followed files, reloads files changed by
+  // other programs and flushes recovery logs of the sheets.
+  void
+  poll(struct workbook& workbook);
+
+  // Blocks until the write in progress, if any, has completed.
+  void
+  wait();
+
+  // Returns number of milliseconds to wait for input before polling again,
+  // or -1 if there is nothing to poll for.
+  int
+  get_timeout(const struct workbook& workbook);
+
+  // Returns description of the write in progress, or progress of loading
+  // given sheet, if any.
+  std::optional<std::u32string>
+  get_status(const struct sheet& sheet);
+}
@@ -0,0 +1,522 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <unordered_map>
+
+#include <laskin/chrono.hpp>
+#include <laskin/error.hpp>
+
+#include "./binary.hpp"
+#include "./csv.hpp"
+#include "./sheet.hpp"
+#include "./utils.hpp"
+
+namespace binary
+{
+  static const std::string_view MAGIC("\x89LEVITE\n", 8);
+
+  enum class tag : std::uint8_t
+  {
+    // Loaded from a file but not classified yet.
+    raw,
+    string,
+    number,
+    boolean,
+    date,
+    time,
+    month,
+    weekday,
+  };
+
+  // Flags of a cell record.
+  static constexpr std::uint8_t HAS_RESULT = 1 << 0;
+
+  // Tag of a change which erases the cell.
+  static constexpr std::uint8_t ERASED = 0xff;
+
+  static const std::vector<std::pair<laskin::value::type, tag>> tags =
+  {
+    { laskin::value::type::string, tag::string },
+    { laskin::value::type::number, tag::number },
+    { laskin::value::type::boolean, tag::boolean },
+    { laskin::value::type::date, tag::date },
+    { laskin::value::type::time, tag::time },
+    { laskin::value::type::month, tag::month },
+    { laskin::value::type::weekday, tag::weekday },
+  };
+
+  static std::optional<tag>
+  get_tag(const laskin::value& value)
+  {
+    for (const auto& pair : tags)
+    {
+      if (value.is(pair.first))
+      {
+        return pair.second;
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  // Returns nothing if the text is not a valid value of given type, which
+  // happens only with corrupted files.
+  static std::optional<laskin::value>
+  make_value(tag tag, const std::u32string& text)
+  {
+    try
+    {
+      switch (tag)
+      {
+        case tag::raw:
+        case tag::string:
+          return laskin::value(text);
+
+        case tag::number:
+          return laskin::value::parse_number(text);
+
+        case tag::boolean:
+          return laskin::value(!text.compare(U"true"));
+
+        case tag::date:
+          return laskin::parse_date(text);
+
+        case tag::time:
+          return laskin::parse_time(text);
+
+        case tag::month:
+          return laskin::parse_month(text);
+
+        case tag::weekday:
+          return laskin::parse_weekday(text);
+      }
+    }
+    catch (const laskin::error&) {}
+
+    return std::nullopt;
+  }
+
+  static void
+  put_uint(std::string& output, std::uint64_t value, int size)
+  {
+    for (int i = 0; i < size; ++i)
+    {
+      output.append(1, static_cast<char>((value >> (i * 8)) & 0xff));
+    }
+  }
+
+  // Overwrites an integer previously written with put_uint(), used for
+  // lengths and counts which are not known in advance.
+  static void
+  patch_uint(
+    std::string& output,
+    std::size_t pos,
+    std::uint64_t value,
+    int size
+  )
+  {
+    for (int i = 0; i < size; ++i)
+    {
+      output[pos + i] = static_cast<char>((value >> (i * 8)) & 0xff);
+    }
+  }
+
+  struct reader
+  {
+    std::string_view input;
+    std::size_t pos = 0;
+    bool ok = true;
+
+    bool
+    has(std::uint64_t count)
+    {
+      if (ok && input.length() - pos >= count)
+      {
+        return true;
+      }
+      ok = false;
+
+      return false;
+    }
+
+    std::uint64_t
+    get_uint(int size)
+    {
+      std::uint64_t result = 0;
+
+      if (has(size))
+      {
+        for (int i = 0; i < size; ++i)
+        {
+          result |= static_cast<std::uint64_t>(
+            static_cast<unsigned char>(input[pos++])
+          ) << (i * 8);
+        }
+      }
+
+      return result;
+    }
+
+    std::string_view
+    get_bytes(std::uint64_t count)
+    {
+      if (!has(count))
+      {
+        return std::string_view();
+      }
+
+      const auto result = input.substr(pos, count);
+
+      pos += count;
+
+      return result;
+    }
+
+    // Returns reader for the contents of a length-prefixed section.
+    reader
+    get_section()
+    {
+      return reader{ get_bytes(get_uint(8)) };
+    }
+  };
+
+  bool
+  is_binary_path(const std::filesystem::path& path)
+  {
+    return path.extension() == ".levite";
+  }
+
+  bool
+  is_binary(const std::string_view& input)
+  {
+    return !input.compare(0, MAGIC.length(), MAGIC);
+  }
+
+  std::optional<std::u32string>
+  read(const std::string_view& input, struct contents& contents)
+  {
+    reader header{ input };
+    std::vector<std::u32string> strings;
+    std::u32string text;
+
+    header.get_bytes(MAGIC.length());
+    if (header.get_uint(4) != VERSION)
+    {
+      return U"Unsupported version of workbook file.";
+    }
+
+    const auto max_col = header.get_uint(4);
+    const auto max_row = header.get_uint(4);
+    auto string_table = header.get_section();
+    const auto string_count = string_table.get_uint(4);
+
+    if (max_col > coordinates::MAX_X)
+    {
+      return U"Spreadsheet too wide.";
+    }
+    else if (max_row > coordinates::MAX_Y)
+    {
+      return U"Spreadsheet too long.";
+    }
+
+    // Every string takes at least four bytes, which bounds the count from
+    // corrupted files before memory is reserved for it.
+    if (string_table.has(string_count * 4))
+    {
+      strings.reserve(string_count);
+    }
+    for (std::uint64_t i = 0; i < string_count && string_table.ok; ++i)
+    {
+      utils::decode_utf8(
+        string_table.get_bytes(string_table.get_uint(4)),
+        text
+      );
+      strings.push_back(text);
+    }
+    if (!string_table.ok)
+    {
+      return U"Corrupted workbook file.";
+    }
+
+    auto get_value = [&strings](
+      reader& column,
+      tag tag
+    ) -> std::optional<laskin::value>
+    {
+      const auto index = column.get_uint(4);
+
+      if (!column.ok || index >= strings.size())
+      {
+        column.ok = false;
+
+        return std::nullopt;
+      }
+
+      return make_value(tag, strings[index]);
+    };
+
+    for (std::uint64_t x = 0; x < max_col; ++x)
+    {
+      auto column = header.get_section();
+      const auto count = column.get_uint(4);
+
+      for (std::uint64_t i = 0; i < count && column.ok; ++i)
+      {
+        const auto y = column.get_uint(4);
+        const auto type = static_cast<tag>(column.get_uint(1));
+        const auto flags = column.get_uint(1);
+        auto value = get_value(column, type);
+        std::optional<laskin::value> result;
+
+        if (flags & HAS_RESULT)
+        {
+          result = get_value(column, static_cast<tag>(column.get_uint(1)));
+        }
+        if (!value || y >= max_row || ((flags & HAS_RESULT) && !result))
+        {
+          column.ok = false;
+          break;
+        }
+        contents.records.push_back({
+          { static_cast<int>(x), static_cast<int>(y) },
+          std::move(*value),
+          type == tag::raw,
+          std::move(result)
+        });
+      }
+      if (!column.ok || !header.ok)
+      {
+        return U"Corrupted workbook file.";
+      }
+    }
+
+    // Sections of changes appended after the file was written. The last one
+    // might have been cut short by an interrupted write.
+    while (header.pos < input.length())
+    {
+      const auto start = header.pos;
+      const auto section = header.get_section();
+
+      if (!header.ok)
+      {
+        break;
+      }
+      read_changes(section.input, contents.changes);
+      contents.changes_size += header.pos - start;
+    }
+
+    return std::nullopt;
+  }
+
+  void
+  put_change(
+    std::string& output,
+    const struct coordinates& coordinates,
+    const laskin::value* value,
+    bool raw
+  )
+  {
+    put_uint(output, coordinates.x, 4);
+    put_uint(output, coordinates.y, 4);
+    if (!value)
+    {
+      put_uint(output, ERASED, 1);
+      return;
+    }
+    put_uint(
+      output,
+      static_cast<std::uint8_t>(
+        raw ? tag::raw : get_tag(*value).value_or(tag::raw)
+      ),
+      1
+    );
+
+    const auto length_pos = output.length();
+
+    put_uint(output, 0, 4);
+    if (value->is(laskin::value::type::string))
+    {
+      utils::append_utf8(value->as_string(), output);
+    } else {
+      utils::append_utf8(value->to_string(), output);
+    }
+    patch_uint(output, length_pos, output.length() - length_pos - 4, 4);
+  }
+
+  void
+  read_changes(const std::string_view& input, std::vector<change>& changes)
+  {
+    reader reader{ input };
+    std::u32string text;
+
+    while (reader.pos < input.length())
+    {
+      const int x = reader.get_uint(4);
+      const int y = reader.get_uint(4);
+      const auto type = reader.get_uint(1);
+      std::optional<laskin::value> value;
+
+      if (type != ERASED)
+      {
+        utils::decode_utf8(reader.get_bytes(reader.get_uint(4)), text);
+        if (reader.ok)
+        {
+          value = make_value(static_cast<tag>(type), text);
+          if (!value)
+          {
+            break;
+          }
+        }
+      }
+      if (!reader.ok)
+      {
+        break;
+      }
+      changes.push_back({
+        { x, y },
+        std::move(value),
+        type == static_cast<std::uint8_t>(tag::raw)
+      });
+    }
+  }
+
+  bool
+  append(const std::filesystem::path& path, const std::string& changes)
+  {
+    const auto fd = ::open(path.c_str(), O_WRONLY | O_APPEND);
+    std::string section;
+    bool result;
+
+    if (fd < 0)
+    {
+      return false;
+    }
+    put_uint(section, changes.length(), 8);
+    section.append(changes);
+    result = csv::write_all(fd, section) && fsync(fd) == 0;
+
+    return ::close(fd) == 0 && result;
+  }
+
+  std::string
+  write(const struct snapshot& snapshot, std::atomic<int>* progress)
+  {
+    std::unordered_map<std::u32string, std::uint32_t> string_indexes;
+    std::vector<const std::u32string*> strings;
+    std::string columns;
+    std::string output(MAGIC);
+
+    auto put_text = [&](const laskin::value& value)
+    {
+      std::pair<decltype(string_indexes)::iterator, bool> entry;
+
+      if (value.is(laskin::value::type::string))
+      {
+        entry = string_indexes.try_emplace(value.as_string(), strings.size());
+      } else {
+        entry = string_indexes.try_emplace(value.to_string(), strings.size());
+      }
+      if (entry.second)
+      {
+        strings.push_back(&entry.first->first);
+      }
+      put_uint(columns, entry.first->second, 4);
+    };
+
+    for (int x = 0; x < snapshot.max_col; ++x)
+    {
+      const auto start = columns.length();
+      std::uint32_t count = 0;
+
+      put_uint(columns, 0, 8);
+      put_uint(columns, 0, 4);
+      for (int y = 0; y < snapshot.max_row; ++y)
+      {
+        const auto cell = snapshot.get({ x, y });
+
+        if (!cell)
+        {
+          continue;
+        }
+
+        const auto it = snapshot.results.find({ x, y });
+        const auto result = it != std::end(snapshot.results)
+          ? get_tag(it->second)
+          : std::nullopt;
+
+        ++count;
+        put_uint(columns, y, 4);
+        // Values of other types can't be restored, so they are written as
+        // text which is classified again when loaded.
+        put_uint(
+          columns,
+          static_cast<std::uint8_t>(
+            cell->raw ? tag::raw : get_tag(cell->value).value_or(tag::raw)
+          ),
+          1
+        );
+        put_uint(columns, result ? HAS_RESULT : 0, 1);
+        put_text(cell->value);
+        if (result)
+        {
+          put_uint(columns, static_cast<std::uint8_t>(*result), 1);
+          put_text(it->second);
+        }
+      }
+      patch_uint(columns, start, columns.length() - start - 8, 8);
+      patch_uint(columns, start + 8, count, 4);
+      if (progress)
+      {
+        progress->store(
+          snapshot.max_row * (x + 1) / snapshot.max_col,
+          std::memory_order_relaxed
+        );
+      }
+    }
+
+    put_uint(output, VERSION, 4);
+    put_uint(output, snapshot.max_col, 4);
+    put_uint(output, snapshot.max_row, 4);
+
+    const auto start = output.length();
+
+    put_uint(output, 0, 8);
+    put_uint(output, strings.size(), 4);
+    for (const auto string : strings)
+    {
+      const auto length_pos = output.length();
+
+      put_uint(output, 0, 4);
+      utils::append_utf8(*string, output);
+      patch_uint(output, length_pos, output.length() - length_pos - 4, 4);
+    }
+    patch_uint(output, start, output.length() - start - 8, 8);
+
+    return output.append(columns);
+  }
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <vector>
+
+#include "./cell.hpp"
+
+struct snapshot;
+
+// Native binary format of Levite. Unlike CSV, it keeps the types of the
+// values and the last evaluated results of formulas, so that a sheet can be
+// opened without classifying or recalculating anything.
+//
+// All integers are unsigned and little endian. The file begins with a magic
+// number, format version and dimensions of the sheet, followed by a table
+// of interned strings and one section for each column. Every section is
+// prefixed with its length in bytes. Changes made after the file was
+// written can be appended to it as additional sections, so that small
+// changes don't require rewriting the whole file.
+namespace binary
+{
+  static constexpr std::uint32_t VERSION = 1;
+
+  struct record
+  {
+    struct coordinates coordinates;
+    laskin::value value;
+    bool raw;
+    std::optional<laskin::value> result;
+  };
+
+  struct change
+  {
+    struct coordinates coordinates;
+    // New value of the cell, or none if it was erased.
+    std::optional<laskin::value> value;
+    bool raw;
+  };
+
+  struct contents
+  {
+    std::vector<record> records;
+    std::vector<change> changes;
+    // Number of bytes taken by sections of changes at the end of the file.
+    std::size_t changes_size = 0;
+  };
+
+  // Tests whether given file name has the extension of the binary format.
+  bool
+  is_binary_path(const std::filesystem::path& path);
+
+  // Tests whether given data begins with the magic number of the format.
+  bool
+  is_binary(const std::string_view& input);
+
+  // Decodes given file contents, or returns an error message.
+  std::optional<std::u32string>
+  read(const std::string_view& input, struct contents& contents);
+
+  // Encodes a change of a cell, erasure if the value is null.
+  void
+  put_change(
+    std::string& output,
+    const struct coordinates& coordinates,
+    const laskin::value* value,
+    bool raw = false
+  );
+
+  // Decodes changes encoded with put_change(). Incomplete change at the end
+  // of the input, left behind by an interrupted write, is ignored.
+  void
+  read_changes(const std::string_view& input, std::vector<change>& changes);
+
+  // Appends section of given encoded changes to an existing file.
+  bool
+  append(const std::filesystem::path& path, const std::string& changes);
+
+  // Encodes given snapshot, counting the rows written so far in `progress`
+  // if given.
+  std::string
+  write(
+    const struct snapshot& snapshot,
+    std::atomic<int>* progress = nullptr
+  );
+}
@@ -23,10 +23,6 @@
  * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
  * POSSIBILITY OF SUCH DAMAGE.
  */
-#include <sstream>
-
-#include <laskin/error.hpp>
-
 #include "./cell.hpp"
 
 cell::value_type
@@ -34,19 +30,10 @@ cell::evaluate(laskin::context& context) const
 {
   if (is_formula())
   {
-    try
-    {
-      context.clear();
-      laskin::quote::parse(value.as_string().substr(1)).call(context);
-
-      return context.pop();
-    }
-    catch (const laskin::error& e)
-    {
-      error = e.message;
+    context.clear();
+    laskin::quote::parse(value.as_string().substr(1)).call(context);
 
-      return laskin::value(U"#ERROR");
-    }
+    return context.pop();
   }
 
   return value;
@@ -33,9 +33,10 @@ struct cell
 {
   using value_type = laskin::value;
 
-  struct coordinates coordinates;
   value_type value;
-  mutable std::optional<std::string> error;
+  // Set for cells loaded from a file whose type has not been decided yet, in
+  // which case the value holds the original text of the field as a string.
+  bool raw = false;
 
   inline bool
   is_formula() const
@@ -27,11 +27,14 @@
 
 #include <peelo/unicode/encoding/utf8.hpp>
 
+#include "./background.hpp"
 #include "./screen.hpp"
 #include "./setting.hpp"
 #include "./sheet.hpp"
+#include "./stats.hpp"
 #include "./termbox2.h"
 #include "./utils.hpp"
+#include "./workbook.hpp"
 
 using command_callback = void(*)(
   sheet*,
@@ -39,6 +42,46 @@ using command_callback = void(*)(
   const std::optional<std::u32string>&
 );
 
+static void
+cmd_autosave(
+  struct sheet*,
+  const std::u32string&,
+  const std::optional<std::u32string>& arg
+)
+{
+  using peelo::unicode::encoding::utf8::decode;
+  using peelo::unicode::encoding::utf8::encode;
+
+  if (!arg)
+  {
+    if (background::autosave_interval > 0)
+    {
+      message = U"Autosaving every " +
+        decode(std::to_string(background::autosave_interval)) +
+        U" seconds.";
+    } else {
+      message = U"Autosave is off.";
+    }
+  }
+  else if (!arg->compare(U"off"))
+  {
+    background::autosave_interval = 0;
+  } else {
+    try
+    {
+      const auto interval = std::stoi(encode(*arg));
+
+      if (interval >= 0)
+      {
+        background::autosave_interval = interval;
+        return;
+      }
+    }
+    catch (const std::exception&) {}
+    message = U"Invalid interval.";
+  }
+}
+
 static void
 cmd_echo(
   struct sheet*,
@@ -56,6 +99,14 @@ cmd_edit(
   const std::optional<std::u32string>& arg
 )
 {
+  using peelo::unicode::encoding::utf8::decode;
+
+  // A write in progress would otherwise finish after the file has been
+  // loaded again.
+  background::wait();
+
+  const auto recovery_filename = sheet->get_recovery_filename();
+
   if (arg)
   {
     sheet->filename = *arg;
@@ -68,6 +119,27 @@ cmd_edit(
   if (const auto error = sheet->load(*sheet->filename, sheet->separator))
   {
     message = *error;
+    return;
+  }
+  // Unsaved changes have been thrown away, so don't offer them for recovery.
+  // They are kept in the log until then, in case the file can't be loaded.
+  sheet->recovery.discard(recovery_filename);
+  if (sheet->workbook)
+  {
+    // The sheet can be referenced again once it has been loaded.
+    for (auto& entry : sheet->workbook->entries)
+    {
+      if (entry.sheet.get() == sheet)
+      {
+        entry.error.reset();
+      }
+    }
+  }
+  if (const auto count = sheet->recover())
+  {
+    message = U"File loaded, recovered " +
+      decode(std::to_string(count)) +
+      U" unsaved changes.";
   } else {
     message = U"File loaded.";
   }
@@ -80,15 +152,96 @@ cmd_quit(
   const std::optional<std::u32string>&
 )
 {
-  if (sheet->modified && command.back() != '!')
+  // Let the write in progress decide whether there are unsaved changes.
+  background::wait();
+
+  const auto modified = sheet->workbook
+    ? sheet->workbook->is_modified()
+    : sheet->modified;
+
+  if (modified && command.back() != '!')
   {
     message = U"File modified.";
     return;
   }
+  if (sheet->workbook)
+  {
+    // Logs of sheets that weren't loaded are left for another session.
+    for (auto& entry : sheet->workbook->entries)
+    {
+      if (entry.loaded)
+      {
+        entry.sheet->recovery.discard(entry.sheet->get_recovery_filename());
+      }
+    }
+  } else {
+    sheet->recovery.discard(sheet->get_recovery_filename());
+  }
   tb_shutdown();
   std::exit(EXIT_SUCCESS);
 }
 
+static void
+cmd_rows(
+  struct sheet* sheet,
+  const std::u32string&,
+  const std::optional<std::u32string>& arg
+)
+{
+  using peelo::unicode::encoding::utf8::decode;
+  using peelo::unicode::encoding::utf8::encode;
+
+  auto filter = sheet->filter;
+
+  if (!arg)
+  {
+    if (!filter.has_row_range())
+    {
+      message = U"All rows of the file are loaded.";
+      return;
+    }
+    message = U"Rows " + decode(std::to_string(filter.first_row + 1)) + U"-";
+    if (filter.last_row)
+    {
+      message += decode(std::to_string(*filter.last_row + 1));
+    }
+    message += U" of the file are loaded.";
+    return;
+  }
+  else if (!sheet->filename)
+  {
+    message = U"No filename.";
+    return;
+  }
+
+  // Let the write in progress decide whether there are unsaved changes, and
+  // finish before the file is loaded again.
+  background::wait();
+
+  if (sheet->modified)
+  {
+    message = U"File modified.";
+    return;
+  }
+  else if (!arg->compare(U"all"))
+  {
+    filter.first_row = 0;
+    filter.last_row.reset();
+  }
+  else if (!filter.parse_rows(encode(*arg)))
+  {
+    message = U"Invalid range of rows.";
+    return;
+  }
+  sheet->filter = filter;
+  if (const auto error = sheet->load(*sheet->filename, sheet->separator))
+  {
+    message = *error;
+  } else {
+    move_to({ cursor.x, 0 });
+  }
+}
+
 static void
 cmd_set(
   sheet*,
@@ -117,6 +270,49 @@ cmd_set(
   }
 }
 
+static void
+cmd_sheet(
+  struct sheet* sheet,
+  const std::u32string&,
+  const std::optional<std::u32string>& arg
+)
+{
+  auto workbook = sheet->workbook;
+
+  if (!workbook)
+  {
+    message = U"No workbook.";
+  }
+  else if (arg)
+  {
+    if (const auto error = workbook->select(*arg))
+    {
+      message = *error;
+    } else {
+      move_to({ 0, 0 });
+    }
+  } else {
+    std::vector<std::u32string> lines;
+
+    for (std::size_t i = 0; i < workbook->entries.size(); ++i)
+    {
+      const auto& entry = workbook->entries[i];
+      auto line = (i == workbook->current ? U"* " : U"  ") + entry.name;
+
+      if (!entry.loaded)
+      {
+        line += U" (not loaded)";
+      }
+      else if (entry.sheet->modified)
+      {
+        line += U" (modified)";
+      }
+      lines.push_back(line);
+    }
+    display_messages(lines);
+  }
+}
+
 static void
 cmd_source(
   struct sheet* sheet,
@@ -141,6 +337,25 @@ cmd_source(
   }
 }
 
+static void
+cmd_stats(
+  sheet* sheet,
+  const std::u32string&,
+  const std::optional<std::u32string>& arg
+)
+{
+  if (!arg)
+  {
+    message = U"Missing statistics category.";
+  }
+  else if (!arg->compare(U"memory"))
+  {
+    display_messages(stats::memory(*sheet));
+  } else {
+    message = U"Unknown statistics category: " + *arg;
+  }
+}
+
 static void
 cmd_write(
   sheet* sheet,
@@ -148,25 +363,33 @@ cmd_write(
   const std::optional<std::u32string>& arg
 )
 {
-  if (arg)
+  if (arg && (!sheet->filename || *sheet->filename != *arg))
   {
+    // Sheet holding part of a file becomes whole contents of the new one.
     sheet->filename = *arg;
+    sheet->filter = {};
   }
   else if (!sheet->filename)
   {
     message = U"No filename.";
     return;
   }
-  if (sheet->save(*sheet->filename, sheet->separator))
+  else if (sheet->filter.is_partial())
+  {
+    message = U"Only part of the file is loaded, write it into another file.";
+    return;
+  }
+  if (background::save(*sheet, *sheet->filename))
   {
-    message = U"File saved.";
+    message.clear();
   } else {
-    message = U"Error saving file.";
+    message = U"Another file is being written.";
   }
 }
 
 static const std::unordered_map<std::u32string, command_callback> commands =
 {
+  { U"autosave", cmd_autosave },
   { U"ec", cmd_echo },
   { U"echo", cmd_echo },
   { U"e", cmd_edit },
@@ -175,10 +398,13 @@ static const std::unordered_map<std::u32string, command_callback> commands =
   { U"q!", cmd_quit },
   { U"quit", cmd_quit },
   { U"quit!", cmd_quit },
+  { U"rows", cmd_rows },
   { U"se", cmd_set },
   { U"set", cmd_set },
+  { U"sheet", cmd_sheet },
   { U"so", cmd_source },
   { U"source", cmd_source },
+  { U"stats", cmd_stats },
   { U"w", cmd_write },
   { U"write", cmd_write },
 };
@@ -256,6 +482,7 @@ sheet::run_script(const std::filesystem::path& path)
 
   if (input.good())
   {
+    begin_batch();
     while (std::getline(input, line))
     {
       ++line_counter;
@@ -272,6 +499,7 @@ sheet::run_script(const std::filesystem::path& path)
         message.clear();
       }
     }
+    commit();
     input.close();
   } else {
     result.push_back(U"Unable to open `" + path.generic_u32string() + U"'.");
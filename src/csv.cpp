@@ -0,0 +1,527 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "./csv.hpp"
+#include "./utils.hpp"
+
+namespace csv
+{
+  mapped_file::mapped_file()
+    : data(nullptr)
+    , size(0) {}
+
+  mapped_file::~mapped_file()
+  {
+    close();
+  }
+
+  bool
+  mapped_file::open(const std::filesystem::path& path)
+  {
+    struct stat st;
+    const auto fd = ::open(path.c_str(), O_RDONLY);
+
+    close();
+    if (fd < 0)
+    {
+      return false;
+    }
+    if (fstat(fd, &st) < 0)
+    {
+      ::close(fd);
+
+      return false;
+    }
+    if (st.st_size > 0)
+    {
+      const auto address = mmap(
+        nullptr,
+        st.st_size,
+        PROT_READ,
+        MAP_PRIVATE,
+        fd,
+        0
+      );
+
+      if (address == MAP_FAILED)
+      {
+        ::close(fd);
+
+        return false;
+      }
+      madvise(address, st.st_size, MADV_SEQUENTIAL);
+      data = static_cast<const char*>(address);
+      size = st.st_size;
+    }
+    ::close(fd);
+
+    return true;
+  }
+
+  void
+  mapped_file::close()
+  {
+    if (data)
+    {
+      munmap(const_cast<char*>(data), size);
+      data = nullptr;
+    }
+    size = 0;
+  }
+
+  output_file::output_file()
+    : fd(-1) {}
+
+  output_file::~output_file()
+  {
+    if (fd >= 0)
+    {
+      ::close(fd);
+      unlink(temporary_path.c_str());
+    }
+  }
+
+  bool
+  output_file::open(const std::filesystem::path& path)
+  {
+    std::error_code ec;
+    struct stat st;
+    std::string name;
+
+    // Replace the file a symbolic link points to instead of the link.
+    if (std::filesystem::is_symlink(path, ec))
+    {
+      this->path = std::filesystem::canonical(path, ec);
+      if (ec)
+      {
+        return false;
+      }
+    } else {
+      this->path = path;
+    }
+    temporary_path = this->path.parent_path() / (
+      "." + this->path.filename().string() + ".XXXXXX"
+    );
+    name = temporary_path.string();
+    if ((fd = mkstemp(name.data())) < 0)
+    {
+      return false;
+    }
+    temporary_path = name;
+
+    // Temporary files are created accessible only by the owner, so give it
+    // the permissions of the file it replaces or the default ones.
+    if (stat(this->path.c_str(), &st) == 0)
+    {
+      fchmod(fd, st.st_mode & 07777);
+    } else {
+      const auto mask = umask(0);
+
+      umask(mask);
+      fchmod(fd, 0666 & ~mask);
+    }
+
+    return true;
+  }
+
+  bool
+  output_file::write(const std::string_view& data)
+  {
+    return write_all(fd, data);
+  }
+
+  bool
+  write_all(int fd, const std::string_view& data)
+  {
+    auto pos = data.data();
+    auto remaining = data.length();
+
+    while (remaining > 0)
+    {
+      const auto written = ::write(fd, pos, remaining);
+
+      if (written < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+
+        return false;
+      }
+      pos += written;
+      remaining -= written;
+    }
+
+    return true;
+  }
+
+  bool
+  output_file::commit()
+  {
+    const auto synced = fsync(fd) == 0;
+    const auto result = ::close(fd) == 0 && synced;
+
+    fd = -1;
+    if (!result || std::rename(temporary_path.c_str(), path.c_str()) != 0)
+    {
+      unlink(temporary_path.c_str());
+
+      return false;
+    }
+
+    // Make the rename itself durable.
+    const auto directory = path.has_parent_path()
+      ? path.parent_path()
+      : std::filesystem::path(".");
+    const auto dir_fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+
+    if (dir_fd >= 0)
+    {
+      fsync(dir_fd);
+      ::close(dir_fd);
+    }
+
+    return true;
+  }
+
+  void
+  write_field(
+    std::string& output,
+    const std::u32string_view& field,
+    char separator
+  )
+  {
+    const auto start = output.length();
+
+    utils::append_utf8(field, output);
+
+    const std::string_view encoded(
+      output.data() + start,
+      output.length() - start
+    );
+
+    if (!scan::needs_quoting(encoded, separator))
+    {
+      return;
+    }
+
+    // Quote the field in place, working backwards from the end so that the
+    // contents can be shifted while the quotes in it are doubled.
+    const auto length = encoded.length();
+    auto src = start + length;
+    auto dst = src + std::count(encoded.begin(), encoded.end(), '"') + 2;
+
+    output.resize(dst);
+    output[--dst] = '"';
+    while (src > start)
+    {
+      const auto c = output[--src];
+
+      output[--dst] = c;
+      if (c == '"')
+      {
+        output[--dst] = '"';
+      }
+    }
+    output[--dst] = '"';
+  }
+
+  std::uint64_t
+  hash_field(
+    std::uint64_t hash,
+    std::size_t column,
+    const std::string_view& field
+  )
+  {
+    // FNV-1a over the column index and the bytes of the field.
+    static constexpr std::uint64_t PRIME = 1099511628211ULL;
+
+    hash = (hash ^ column) * PRIME;
+    for (const auto c : field)
+    {
+      hash = (hash ^ static_cast<unsigned char>(c)) * PRIME;
+    }
+
+    return (hash ^ 0xff) * PRIME;
+  }
+
+  std::vector<std::uint64_t>
+  hash_records(
+    const std::string_view& input,
+    char separator,
+    std::size_t limit
+  )
+  {
+    std::vector<std::uint64_t> result;
+    std::string scratch;
+    auto hash = EMPTY_RECORD_HASH;
+
+    if (limit == 0)
+    {
+      return result;
+    }
+    parse(
+      input,
+      separator,
+      scratch,
+      [&hash](std::size_t column, const std::string_view& field)
+      {
+        if (!field.empty())
+        {
+          hash = hash_field(hash, column, field);
+        }
+
+        return true;
+      },
+      [&result, &hash, limit]()
+      {
+        result.push_back(hash);
+        hash = EMPTY_RECORD_HASH;
+
+        return result.size() < limit;
+      }
+    );
+
+    return result;
+  }
+
+  // Skips records like skip_records(), but can also begin inside a quoted
+  // field.
+  static std::size_t
+  skip(
+    const std::string_view& input,
+    std::size_t pos,
+    std::size_t count,
+    char separator,
+    bool quoted
+  )
+  {
+    const auto length = input.length();
+    const auto begin = input.data();
+    const auto end = begin + length;
+
+    while (count > 0 && pos < length)
+    {
+      if (quoted || input[pos] == '"')
+      {
+        if (!quoted)
+        {
+          ++pos;
+        }
+        quoted = false;
+        for (;;)
+        {
+          const auto quote = input.find('"', pos);
+
+          if (quote == std::string_view::npos)
+          {
+            pos = length;
+            break;
+          }
+          pos = quote + 1;
+          if (pos < length && input[pos] == '"')
+          {
+            ++pos;
+            continue;
+          }
+          break;
+        }
+      }
+      // Rest of an unquoted field, or garbage after a closing quote, where
+      // quotes are taken literally.
+      for (;;)
+      {
+        pos = scan::find_special(begin + pos, end, separator) - begin;
+        if (pos < length && input[pos] == '"')
+        {
+          ++pos;
+          continue;
+        }
+        break;
+      }
+      if (pos < length && input[pos] == separator)
+      {
+        if (++pos == length)
+        {
+          --count;
+        }
+        continue;
+      }
+      if (pos < length && input[pos] == '\r')
+      {
+        ++pos;
+      }
+      if (pos < length && input[pos] == '\n')
+      {
+        ++pos;
+      }
+      --count;
+    }
+
+    return pos;
+  }
+
+  std::size_t
+  skip_records(
+    const std::string_view& input,
+    std::size_t pos,
+    std::size_t count,
+    char separator
+  )
+  {
+    return skip(input, pos, count, separator, false);
+  }
+
+  std::size_t
+  find_last_record_end(const std::string_view& input, char separator)
+  {
+    const auto length = input.length();
+    std::size_t result = 0;
+
+    for (std::size_t pos = 0; pos < length;)
+    {
+      pos = skip_records(input, pos, 1, separator);
+      // Last record is complete only if it ends in a line feed, as a
+      // carriage return may still be followed by one.
+      if (pos < length || input[pos - 1] == '\n')
+      {
+        result = pos;
+      }
+    }
+
+    return result;
+  }
+
+  // Record boundaries found in a chunk of CSV data, both when the chunk
+  // begins outside of quotes and when it begins inside a quoted field.
+  struct chunk_scan
+  {
+    // First record boundary in the chunk, or npos if there is none.
+    std::size_t boundary[2];
+    // Whether the chunk ends inside a quoted field.
+    bool quoted[2];
+  };
+
+  std::vector<std::string_view>
+  split(const std::string_view& input, std::size_t count, char separator)
+  {
+    const auto length = input.length();
+    std::vector<std::size_t> starts(count + 1);
+    std::vector<chunk_scan> scans(count);
+    std::vector<std::thread> threads;
+    std::vector<std::string_view> result;
+    std::size_t start = 0;
+    bool quoted = false;
+
+    if (count < 2 || length < count)
+    {
+      return { input };
+    }
+
+    // Chunks are scanned from just after a line feed, so that they begin
+    // either at a record boundary, or inside a quoted field but never in the
+    // middle of an escaped quote.
+    for (std::size_t i = 1; i < count; ++i)
+    {
+      const auto pos = input.find('\n', length / count * i);
+
+      starts[i] = std::max(
+        starts[i - 1],
+        pos == std::string_view::npos ? length : pos + 1
+      );
+    }
+    starts[count] = length;
+
+    // Whether a chunk begins inside a quoted field depends on all of the
+    // data before it, so each chunk is scanned in parallel for both cases.
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      threads.emplace_back([&input, &starts, &scans, separator, i]()
+      {
+        const auto first = starts[i];
+        const auto last = starts[i + 1];
+
+        // The first chunk is known to begin outside of quotes.
+        for (int state = 0; state < (i > 0 ? 2 : 1); ++state)
+        {
+          auto pos = first;
+
+          if (first == last)
+          {
+            scans[i].boundary[state] = std::string_view::npos;
+            scans[i].quoted[state] = state;
+            continue;
+          }
+          else if (state)
+          {
+            pos = skip(input, pos, 1, separator, true);
+          }
+          scans[i].boundary[state] = pos < last
+            ? pos
+            : std::string_view::npos;
+          while (pos < last)
+          {
+            pos = skip(input, pos, 1, separator, false);
+          }
+          // A record can't continue past a line feed outside of quotes.
+          scans[i].quoted[state] = pos > last;
+        }
+      });
+    }
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+
+    // Follow the actual state from the beginning of the data, cutting the
+    // chunks at the boundaries found for it.
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      const auto boundary = scans[i].boundary[quoted];
+
+      if (boundary != std::string_view::npos && boundary > start)
+      {
+        result.push_back(input.substr(start, boundary - start));
+        start = boundary;
+      }
+      quoted = scans[i].quoted[quoted];
+    }
+    result.push_back(input.substr(start));
+
+    return result;
+  }
+}
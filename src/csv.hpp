@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "./scan.hpp"
+
+namespace csv
+{
+  // Read only memory mapping of a whole file.
+  struct mapped_file
+  {
+    const char* data;
+    std::size_t size;
+
+    explicit mapped_file();
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    ~mapped_file();
+
+    bool
+    open(const std::filesystem::path& path);
+
+    void
+    close();
+
+    inline std::string_view
+    view() const
+    {
+      return std::string_view(data, size);
+    }
+  };
+
+  // File which is written into a temporary file in the same directory and
+  // renamed over the destination once complete, so that the destination is
+  // never left partially written.
+  struct output_file
+  {
+    std::filesystem::path path;
+    std::filesystem::path temporary_path;
+    int fd;
+
+    explicit output_file();
+    output_file(const output_file&) = delete;
+    output_file& operator=(const output_file&) = delete;
+    ~output_file();
+
+    bool
+    open(const std::filesystem::path& path);
+
+    bool
+    write(const std::string_view& data);
+
+    bool
+    commit();
+  };
+
+  // Writes all of given data into a file descriptor, retrying after partial
+  // writes and interruptions.
+  bool
+  write_all(int fd, const std::string_view& data);
+
+  // Appends given field to the output encoded in UTF-8, quoted if needed.
+  void
+  write_field(
+    std::string& output,
+    const std::u32string_view& field,
+    char separator
+  );
+
+  // Initial value of record hashes, which is also the hash of an empty
+  // record.
+  static constexpr std::uint64_t EMPTY_RECORD_HASH = 14695981039346656037ULL;
+
+  // Combines column and contents of a non-empty field into hash of the
+  // record it belongs to. Records with the same hash have the same fields.
+  std::uint64_t
+  hash_field(
+    std::uint64_t hash,
+    std::size_t column,
+    const std::string_view& field
+  );
+
+  // Returns hashes of at most `limit` first records of given CSV data.
+  std::vector<std::uint64_t>
+  hash_records(
+    const std::string_view& input,
+    char separator,
+    std::size_t limit
+  );
+
+  // Returns position just after `count` records following given position in
+  // CSV data, or end of the data if there are fewer records in it. Records
+  // are delimited exactly like parse() delimits them, so a quote opens a
+  // quoted field only when it's the first byte of the field.
+  std::size_t
+  skip_records(
+    const std::string_view& input,
+    std::size_t pos,
+    std::size_t count,
+    char separator
+  );
+
+  // Returns position just after the last record in CSV data that is
+  // terminated by a line break, or zero if the data contains no complete
+  // records.
+  std::size_t
+  find_last_record_end(const std::string_view& input, char separator);
+
+  // Splits given CSV data into at most `count` chunks of roughly equal size
+  // which begin and end at record boundaries. The chunks are scanned in
+  // parallel, resolving whether each of them begins inside a quoted field
+  // only afterwards.
+  std::vector<std::string_view>
+  split(const std::string_view& input, std::size_t count, char separator);
+
+  // Tokenizes given CSV data, calling `on_field` with the column index and
+  // contents of each field and `on_record` at the end of each record. Either
+  // callback can stop the parsing by returning false. Unquoted fields are
+  // passed as views into the input, quoted ones are unescaped into `scratch`.
+  // Returns the position where parsing stopped.
+  template<class FieldCallback, class RecordCallback>
+  std::size_t
+  parse(
+    const std::string_view& input,
+    char separator,
+    std::string& scratch,
+    FieldCallback on_field,
+    RecordCallback on_record
+  )
+  {
+    const auto length = input.length();
+    std::size_t pos = 0;
+    std::size_t column = 0;
+
+    while (pos < length)
+    {
+      std::string_view field;
+
+      if (input[pos] == '"')
+      {
+        scratch.clear();
+        ++pos;
+        for (;;)
+        {
+          const auto quote = input.find('"', pos);
+
+          if (quote == std::string_view::npos)
+          {
+            scratch.append(input.data() + pos, length - pos);
+            pos = length;
+            break;
+          }
+          scratch.append(input.data() + pos, quote - pos);
+          pos = quote + 1;
+          if (pos < length && input[pos] == '"')
+          {
+            scratch.append(1, '"');
+            ++pos;
+            continue;
+          }
+          break;
+        }
+        // Be lenient about garbage between closing quote and separator.
+        while (
+          pos < length &&
+          input[pos] != separator &&
+          input[pos] != '\n' &&
+          input[pos] != '\r'
+        )
+        {
+          scratch.append(1, input[pos++]);
+        }
+        field = scratch;
+      } else {
+        const auto start = pos;
+
+        // Quotes in the middle of an unquoted field are taken literally.
+        for (;;)
+        {
+          pos = scan::find_special(
+            input.data() + pos,
+            input.data() + length,
+            separator
+          ) - input.data();
+          if (pos < length && input[pos] == '"')
+          {
+            ++pos;
+            continue;
+          }
+          break;
+        }
+        field = input.substr(start, pos - start);
+      }
+
+      if (!on_field(column, field))
+      {
+        return pos;
+      }
+
+      if (pos < length && input[pos] == separator)
+      {
+        ++column;
+        if (++pos == length)
+        {
+          if (!on_field(column, std::string_view()) || !on_record())
+          {
+            return pos;
+          }
+        }
+        continue;
+      }
+      if (pos < length && input[pos] == '\r')
+      {
+        ++pos;
+      }
+      if (pos < length && input[pos] == '\n')
+      {
+        ++pos;
+      }
+      column = 0;
+      if (!on_record())
+      {
+        return pos;
+      }
+    }
+
+    return pos;
+  }
+}
@@ -425,6 +425,17 @@ normal_mode(struct sheet& sheet, const tb_event& event)
     case TB_KEY_PGUP:
       scroll_up((tb_height() - 3) / 2);
       break;
+
+    // Redo last undone change.
+    case TB_KEY_CTRL_R:
+      if (const auto coords = sheet.redo())
+      {
+        move_to(*coords);
+        message.clear();
+      } else {
+        message = U"Already at newest change.";
+      }
+      return;
   }
 
   if (awaiting_register_name && event.ch != 0)
@@ -556,6 +567,11 @@ normal_mode(struct sheet& sheet, const tb_event& event)
       move_cursor(direction::right);
       break;
 
+    // Move to the last row containing data.
+    case 'G':
+      move_to({ cursor.x, std::max(0, sheet.max_row - 1) });
+      break;
+
     // Concatenate current cell with the one above it.
     case 'J':
       if (sheet.join({ cursor.x, cursor.y - 1 }, cursor))
@@ -572,6 +588,17 @@ normal_mode(struct sheet& sheet, const tb_event& event)
       }
       break;
 
+    // Undo last change.
+    case 'u':
+      if (const auto coords = sheet.undo())
+      {
+        move_to(*coords);
+        message.clear();
+      } else {
+        message = U"Already at oldest change.";
+      }
+      break;
+
     case 'v':
       visual_anchor = cursor;
       current_mode = mode::visual;
@@ -701,6 +728,7 @@ visual_mode(struct sheet& sheet, const tb_event& event)
         const int min_y = std::min(visual_anchor->y, cursor.y);
         const int max_y = std::max(visual_anchor->y, cursor.y);
 
+        sheet.begin_batch();
         for (int y = min_y; y <= max_y; ++y)
         {
           for (int x = min_x; x <= max_x; ++x)
@@ -708,6 +736,7 @@ visual_mode(struct sheet& sheet, const tb_event& event)
             sheet.erase({ x, y });
           }
         }
+        sheet.commit();
         leave_visual_mode();
         return;
       }
@@ -736,11 +765,18 @@ visual_mode(struct sheet& sheet, const tb_event& event)
 }
 
 void
-handle_event(struct sheet& sheet)
+handle_event(struct sheet& sheet, int timeout)
 {
   tb_event event;
 
-  tb_poll_event(&event);
+  if (timeout < 0)
+  {
+    tb_poll_event(&event);
+  }
+  else if (tb_peek_event(&event, timeout) != TB_OK)
+  {
+    return;
+  }
 
   if (event.type == TB_EVENT_KEY)
   {
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "./binary.hpp"
+#include "./csv.hpp"
+#include "./follow.hpp"
+#include "./gzip.hpp"
+
+// Maximum amount of data read at once, so that the user interface stays
+// responsive while a large backlog is being read.
+static constexpr std::size_t READ_LIMIT = 1 << 22;
+
+follower::follower()
+  : fd(-1)
+  , stream(false)
+  , position(0)
+  , backlog(false) {}
+
+follower::~follower()
+{
+  close();
+}
+
+void
+follower::close()
+{
+  if (fd > STDIN_FILENO)
+  {
+    ::close(fd);
+  }
+  fd = -1;
+}
+
+std::optional<std::u32string>
+follower::open(
+  const std::optional<std::filesystem::path>& path,
+  std::size_t offset
+)
+{
+  struct stat st;
+  char magic[8];
+
+  close();
+  pending.clear();
+  backlog = false;
+  position = offset;
+  if (!path)
+  {
+    fd = STDIN_FILENO;
+  }
+  else if ((fd = ::open(path->c_str(), O_RDONLY)) < 0)
+  {
+    return U"Unable to open file.";
+  }
+  if (fstat(fd, &st) < 0)
+  {
+    close();
+
+    return U"Unable to open file.";
+  }
+  stream = !S_ISREG(st.st_mode);
+  if (stream)
+  {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    return std::nullopt;
+  }
+
+  // Appending to compressed or binary files doesn't add rows to them.
+  const auto length = pread(fd, magic, sizeof(magic), 0);
+
+  if (length > 0)
+  {
+    const std::string_view header(magic, length);
+
+    if (gzip::is_compressed(header) || binary::is_binary(header))
+    {
+      close();
+
+      return U"Only plain CSV files can be followed.";
+    }
+  }
+
+  return std::nullopt;
+}
+
+std::optional<std::u32string>
+follower::read(std::string& output, char separator)
+{
+  char buffer[1 << 16];
+  std::size_t total = 0;
+  bool eof = false;
+
+  if (fd < 0)
+  {
+    return std::nullopt;
+  }
+  if (!stream)
+  {
+    struct stat st;
+
+    if (fstat(fd, &st) < 0)
+    {
+      close();
+
+      return U"Unable to read followed file.";
+    }
+    else if (static_cast<std::size_t>(st.st_size) < position)
+    {
+      close();
+
+      return U"Followed file was truncated.";
+    }
+  }
+  backlog = false;
+  while (total < READ_LIMIT)
+  {
+    const auto count = stream
+      ? ::read(fd, buffer, sizeof(buffer))
+      : pread(fd, buffer, sizeof(buffer), position);
+
+    if (count < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      else if (errno == EAGAIN || errno == EWOULDBLOCK)
+      {
+        break;
+      }
+      close();
+
+      return U"Unable to read followed file.";
+    }
+    else if (count == 0)
+    {
+      eof = stream;
+      break;
+    }
+    pending.append(buffer, count);
+    position += count;
+    total += count;
+  }
+  backlog = total >= READ_LIMIT;
+
+  // Once a pipe has been closed, whatever is left forms the last record.
+  const auto end = eof
+    ? pending.length()
+    : csv::find_last_record_end(pending, separator);
+
+  output.append(pending, 0, end);
+  pending.erase(0, end);
+  if (eof)
+  {
+    close();
+  }
+
+  return std::nullopt;
+}
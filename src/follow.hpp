@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+
+// Reads rows appended to a file, or written into a pipe, after the sheet has
+// been loaded from it. Files are polled for growth, pipes are read without
+// blocking until the writer closes them.
+struct follower
+{
+  int fd;
+  // Whether the input is a pipe or other stream instead of a regular file.
+  bool stream;
+  // Position of the next byte to read from a regular file.
+  std::size_t position;
+  // Data read so far which does not yet form complete records.
+  std::string pending;
+  // Whether more data was available than was read at once.
+  bool backlog;
+
+  explicit follower();
+  follower(const follower&) = delete;
+  follower& operator=(const follower&) = delete;
+  ~follower();
+
+  // Starts following given file from given position, or standard input if
+  // no file is given.
+  std::optional<std::u32string>
+  open(
+    const std::optional<std::filesystem::path>& path,
+    std::size_t offset = 0
+  );
+
+  // Appends complete records read since the last call into the output,
+  // which are delimited with given field separator. Returns an error if the
+  // input can no longer be followed.
+  std::optional<std::u32string>
+  read(std::string& output, char separator);
+
+  // Tests whether the writer of a pipe has closed it.
+  inline bool
+  is_closed() const
+  {
+    return fd < 0;
+  }
+
+private:
+  void
+  close();
+};
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <atomic>
+
+#include "./grid.hpp"
+
+grid::grid()
+  : tiles()
+  , count(0) {}
+
+grid::tile&
+grid::get_tile_for_update(int index)
+{
+  auto& tile = tiles[index];
+
+  if (!tile)
+  {
+    tile = std::make_shared<grid::tile>();
+  }
+  else if (tile.use_count() > 1)
+  {
+    tile = std::make_shared<grid::tile>(*tile);
+  } else {
+    // Pairs with the release performed when another thread drops its copy
+    // of the tile, so that its reads happen before our writes.
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+
+  return *tile;
+}
+
+cell*
+grid::find_for_update(const coordinates& coords)
+{
+  const auto index = coords.y / TILE_HEIGHT;
+
+  if (tiles[index])
+  {
+    auto& tile = get_tile_for_update(index);
+    const auto it = tile.find(coords);
+
+    if (it != std::end(tile))
+    {
+      return &it->second;
+    }
+  }
+
+  return nullptr;
+}
+
+bool
+grid::insert_or_assign(
+  const coordinates& coords,
+  const laskin::value& value,
+  bool raw
+)
+{
+  auto& tile = get_tile_for_update(coords.y / TILE_HEIGHT);
+  const auto [it, inserted] = tile.try_emplace(coords, cell{ value, raw });
+
+  if (inserted)
+  {
+    ++count;
+  } else {
+    it->second.value = value;
+    it->second.raw = raw;
+  }
+
+  return inserted;
+}
+
+std::optional<laskin::value>
+grid::erase(const coordinates& coords)
+{
+  const auto index = coords.y / TILE_HEIGHT;
+  std::optional<laskin::value> value;
+
+  if (!find(coords))
+  {
+    return std::nullopt;
+  }
+
+  auto& tile = get_tile_for_update(index);
+  const auto it = tile.find(coords);
+
+  value = std::move(it->second.value);
+  tile.erase(it);
+  --count;
+  if (tile.empty())
+  {
+    tiles[index].reset();
+  }
+
+  return value;
+}
+
+void
+grid::clear()
+{
+  for (auto& tile : tiles)
+  {
+    tile.reset();
+  }
+  count = 0;
+}
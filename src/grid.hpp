@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+
+#include "./cell.hpp"
+
+// Sparse storage of cells, split into tiles of consecutive rows. Tiles are
+// reference counted and copied on write, so copying a grid is cheap and the
+// copy stays unchanged while the original one is being modified.
+struct grid
+{
+  static constexpr int TILE_HEIGHT = 32;
+  static constexpr int TILE_COUNT = (
+    coordinates::MAX_Y + TILE_HEIGHT - 1
+  ) / TILE_HEIGHT;
+
+  using tile = std::unordered_map<coordinates, cell>;
+  using container_type = std::array<std::shared_ptr<tile>, TILE_COUNT>;
+
+  container_type tiles;
+  std::size_t count;
+
+  explicit grid();
+
+  inline std::size_t
+  size() const
+  {
+    return count;
+  }
+
+  inline const cell*
+  find(const coordinates& coords) const
+  {
+    if (const auto& tile = tiles[coords.y / TILE_HEIGHT])
+    {
+      const auto it = tile->find(coords);
+
+      if (it != std::end(*tile))
+      {
+        return &it->second;
+      }
+    }
+
+    return nullptr;
+  }
+
+  tile&
+  get_tile_for_update(int index);
+
+  cell*
+  find_for_update(const coordinates& coords);
+
+  bool
+  insert_or_assign(
+    const coordinates& coords,
+    const laskin::value& value,
+    bool raw = false
+  );
+
+  std::optional<laskin::value>
+  erase(const coordinates& coords);
+
+  void
+  clear();
+
+  template<class Callback>
+  void
+  for_each(Callback callback) const
+  {
+    for (const auto& tile : tiles)
+    {
+      if (tile)
+      {
+        for (const auto& pair : *tile)
+        {
+          callback(pair.first, pair.second);
+        }
+      }
+    }
+  }
+};
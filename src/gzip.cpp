@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <algorithm>
+#include <limits>
+
+#include "./gzip.hpp"
+
+namespace gzip
+{
+  // Size of the buffers used for compressed and decompressed data.
+  static constexpr std::size_t BUFFER_SIZE = 1 << 16;
+
+  bool
+  is_compressed(const std::string_view& input)
+  {
+    return input.length() >= 2 && input[0] == '\x1f' && input[1] == '\x8b';
+  }
+
+  bool
+  is_compressed_path(const std::filesystem::path& path)
+  {
+    return path.extension() == ".gz";
+  }
+
+  // Largest amount of data zlib can be given at once.
+  static constexpr std::size_t MAX_SLICE = std::numeric_limits<uInt>::max();
+
+  decompressor::decompressor(const std::string_view& input)
+    : stream()
+    , input(input)
+    , finished(false)
+  {
+    // Let zlib detect the gzip header.
+    initialized = inflateInit2(&stream, 15 + 32) == Z_OK;
+  }
+
+  decompressor::~decompressor()
+  {
+    if (initialized)
+    {
+      inflateEnd(&stream);
+    }
+  }
+
+  std::optional<std::u32string>
+  decompressor::read(std::string& output)
+  {
+    const auto length = output.length();
+
+    if (!initialized)
+    {
+      return U"Unable to decompress file.";
+    }
+    output.resize(length + BUFFER_SIZE);
+    stream.next_out = reinterpret_cast<Bytef*>(output.data() + length);
+    stream.avail_out = BUFFER_SIZE;
+    while (stream.avail_out > 0 && !finished)
+    {
+      // Files larger than zlib can handle at once are fed to it in slices.
+      if (stream.avail_in == 0 && !input.empty())
+      {
+        const auto slice = std::min(input.length(), MAX_SLICE);
+
+        stream.next_in = reinterpret_cast<Bytef*>(
+          const_cast<char*>(input.data())
+        );
+        stream.avail_in = slice;
+        input.remove_prefix(slice);
+      }
+
+      const auto result = inflate(&stream, Z_NO_FLUSH);
+
+      if (result == Z_STREAM_END)
+      {
+        // Files can consist of multiple concatenated gzip members.
+        if (stream.avail_in == 0 && input.empty())
+        {
+          finished = true;
+        } else {
+          inflateReset(&stream);
+        }
+      }
+      else if (result != Z_OK)
+      {
+        output.resize(length);
+
+        return U"Corrupted compressed file.";
+      }
+    }
+    output.resize(length + BUFFER_SIZE - stream.avail_out);
+
+    return std::nullopt;
+  }
+
+  compressor::compressor(int level)
+    : stream()
+    , buffer(BUFFER_SIZE, '\0')
+  {
+    // Window bits over 15 make zlib write a gzip header.
+    initialized = deflateInit2(
+      &stream,
+      std::clamp(level, 1, 9),
+      Z_DEFLATED,
+      15 + 16,
+      8,
+      Z_DEFAULT_STRATEGY
+    ) == Z_OK;
+  }
+
+  compressor::~compressor()
+  {
+    if (initialized)
+    {
+      deflateEnd(&stream);
+    }
+  }
+
+  bool
+  compressor::write(csv::output_file& file, const std::string_view& data)
+  {
+    return deflate(file, data, Z_NO_FLUSH);
+  }
+
+  bool
+  compressor::finish(csv::output_file& file)
+  {
+    return deflate(file, std::string_view(), Z_FINISH);
+  }
+
+  bool
+  compressor::deflate(
+    csv::output_file& file,
+    const std::string_view& data,
+    int flush
+  )
+  {
+    if (!initialized)
+    {
+      return false;
+    }
+    // Data larger than zlib can handle at once is given to it in slices, of
+    // which only the last one is flushed.
+    if (data.length() > MAX_SLICE)
+    {
+      return (
+        deflate(file, data.substr(0, MAX_SLICE), Z_NO_FLUSH) &&
+        deflate(file, data.substr(MAX_SLICE), flush)
+      );
+    }
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = data.length();
+    do
+    {
+      stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
+      stream.avail_out = buffer.length();
+
+      const auto result = ::deflate(&stream, flush);
+
+      if (result == Z_STREAM_ERROR)
+      {
+        return false;
+      }
+      if (!file.write(
+        std::string_view(buffer.data(), buffer.length() - stream.avail_out)
+      ))
+      {
+        return false;
+      }
+    }
+    while (stream.avail_out == 0);
+
+    return true;
+  }
+}
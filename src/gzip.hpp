@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <zlib.h>
+
+#include "./csv.hpp"
+
+// Transparent gzip compression of files.
+namespace gzip
+{
+  // Tests whether given data begins with the gzip magic number.
+  bool
+  is_compressed(const std::string_view& input);
+
+  // Tests whether given file name has the extension of gzip files.
+  bool
+  is_compressed_path(const std::filesystem::path& path);
+
+  // Decompresses gzip data block by block, so that only the parts of it
+  // which are needed have to be kept in memory.
+  struct decompressor
+  {
+    z_stream stream;
+    // Compressed data not yet given to zlib.
+    std::string_view input;
+    bool initialized;
+    bool finished;
+
+    explicit decompressor(const std::string_view& input);
+    decompressor(const decompressor&) = delete;
+    decompressor& operator=(const decompressor&) = delete;
+    ~decompressor();
+
+    // Appends next block of decompressed data into the output, or returns
+    // an error message. Sets `finished` once all of the data has been
+    // decompressed.
+    std::optional<std::u32string>
+    read(std::string& output);
+  };
+
+  // Compresses data written through it into an output file.
+  struct compressor
+  {
+    z_stream stream;
+    std::string buffer;
+    bool initialized;
+
+    explicit compressor(int level);
+    compressor(const compressor&) = delete;
+    compressor& operator=(const compressor&) = delete;
+    ~compressor();
+
+    bool
+    write(csv::output_file& file, const std::string_view& data);
+
+    // Writes rest of the compressed data into the file.
+    bool
+    finish(csv::output_file& file);
+
+  private:
+    bool
+    deflate(csv::output_file& file, const std::string_view& data, int flush);
+  };
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "./journal.hpp"
+#include "./setting.hpp"
+#include "./stats.hpp"
+
+journal::journal()
+  : size(0)
+  , depth(0) {}
+
+static void
+push(journal& journal, journal::entry&& entry)
+{
+  const auto limit = static_cast<std::size_t>(
+    setting::get_int(setting::key::undo_limit)
+  ) * 1024;
+
+  for (const auto& e : journal.redo_stack)
+  {
+    journal.size -= journal::get_size(e);
+  }
+  journal.redo_stack.clear();
+  journal.size += journal::get_size(entry);
+  journal.undo_stack.push_back(std::move(entry));
+
+  // Forget the oldest changes once the history grows beyond the limit.
+  while (journal.size > limit && !journal.undo_stack.empty())
+  {
+    journal.size -= journal::get_size(journal.undo_stack.front());
+    journal.undo_stack.pop_front();
+  }
+}
+
+void
+journal::commit()
+{
+  if (depth > 0 && --depth == 0 && !current.empty())
+  {
+    current.shrink_to_fit();
+    push(*this, std::move(current));
+    current = entry();
+  }
+}
+
+void
+journal::record(
+  const coordinates& coords,
+  std::optional<laskin::value> before,
+  std::optional<laskin::value> after
+)
+{
+  if (!before && !after)
+  {
+    return;
+  }
+  if (depth > 0)
+  {
+    current.push_back({ coords, std::move(before), std::move(after) });
+  } else {
+    push(*this, { { coords, std::move(before), std::move(after) } });
+  }
+}
+
+void
+journal::clear()
+{
+  undo_stack.clear();
+  redo_stack.clear();
+  current.clear();
+  size = 0;
+}
+
+std::size_t
+journal::get_size(const entry& entry)
+{
+  std::size_t result = entry.capacity() * sizeof(change);
+
+  for (const auto& change : entry)
+  {
+    if (change.before)
+    {
+      result += stats::get_value_size(*change.before) - sizeof(laskin::value);
+    }
+    if (change.after)
+    {
+      result += stats::get_value_size(*change.after) - sizeof(laskin::value);
+    }
+  }
+
+  return result;
+}
@@ -29,11 +29,12 @@
 #include <peelo/unicode/encoding/utf8.hpp>
 #include <peelo/xdg.hpp>
 
+#include "./background.hpp"
 #include "./screen.hpp"
-#include "./sheet.hpp"
 #include "./termbox2.h"
+#include "./workbook.hpp"
 
-void handle_event(struct sheet& sheet);
+void handle_event(struct sheet& sheet, int timeout);
 void render(struct sheet& sheet);
 
 static void
@@ -42,10 +43,32 @@ print_usage(std::ostream& output, const char* executable_name)
   output << std::endl
          << "Usage: "
          << executable_name
-         << " [switches] [filename]"
+         << " [switches] [filename...]"
+         << std::endl
+         << "Filename `-' reads rows from the standard input as they arrive."
          << std::endl
          << "  -s separator      Separator character to use. (Default `,')"
          << std::endl
+         << "  -f                Follow the first file for appended rows."
+         << std::endl
+         << "  --rows start-end  Load only given range of rows of the files."
+         << std::endl
+         << "  --columns A,C,F   Load only given columns of the files."
+         << std::endl
+         << "  --where program   Load only rows for which given Laskin program"
+         << std::endl
+         << "                    returns true. Columns are referred to by"
+         << std::endl
+         << "                    their letters."
+         << std::endl
+         << "  --sample count    Load only a random sample of rows of the"
+         << std::endl
+         << "                    files."
+         << std::endl
+         << "  --header          Always load first row of the files when"
+         << std::endl
+         << "                    sampling."
+         << std::endl
          << "  --version         Print the version."
          << std::endl
          << "  --help            Display this message."
@@ -54,8 +77,16 @@ print_usage(std::ostream& output, const char* executable_name)
 }
 
 static void
-parse_args(struct sheet& sheet, int argc, char** argv)
+parse_args(
+  struct workbook& workbook,
+  std::vector<std::filesystem::path>& filenames,
+  bool& follow,
+  int argc,
+  char** argv
+)
 {
+  using peelo::unicode::encoding::utf8::decode;
+
   int offset = 1;
 
   while (offset < argc)
@@ -68,12 +99,13 @@ parse_args(struct sheet& sheet, int argc, char** argv)
     }
     else if (*arg != '-')
     {
-      sheet.filename = arg;
-      break;
+      filenames.push_back(arg);
+      continue;
     }
     else if (!arg[1])
     {
-      break;
+      filenames.push_back(arg);
+      continue;
     }
     else if (arg[1] == '-')
     {
@@ -86,6 +118,62 @@ parse_args(struct sheet& sheet, int argc, char** argv)
       {
         std::cerr << "Levite 1.0.0" << std::endl;
         std::exit(EXIT_SUCCESS);
+      }
+      else if (!std::strcmp(arg, "--rows"))
+      {
+        if (offset >= argc || !workbook.filter.parse_rows(argv[offset++]))
+        {
+          std::cerr << "Range of rows expected for the --rows option."
+                    << std::endl;
+          print_usage(std::cerr, argv[0]);
+          std::exit(EXIT_FAILURE);
+        }
+        continue;
+      }
+      else if (!std::strcmp(arg, "--columns"))
+      {
+        if (
+          offset >= argc ||
+          !workbook.filter.parse_columns(argv[offset++])
+        )
+        {
+          std::cerr << "List of columns expected for the --columns option."
+                    << std::endl;
+          print_usage(std::cerr, argv[0]);
+          std::exit(EXIT_FAILURE);
+        }
+        continue;
+      }
+      else if (!std::strcmp(arg, "--where"))
+      {
+        if (offset >= argc)
+        {
+          std::cerr << "Program expected for the --where option."
+                    << std::endl;
+          print_usage(std::cerr, argv[0]);
+          std::exit(EXIT_FAILURE);
+        }
+        workbook.filter.where = decode(argv[offset++]);
+        continue;
+      }
+      else if (!std::strcmp(arg, "--sample"))
+      {
+        const auto count = offset < argc ? std::atoi(argv[offset++]) : 0;
+
+        if (count < 1)
+        {
+          std::cerr << "Number of rows expected for the --sample option."
+                    << std::endl;
+          print_usage(std::cerr, argv[0]);
+          std::exit(EXIT_FAILURE);
+        }
+        workbook.filter.sample = count;
+        continue;
+      }
+      else if (!std::strcmp(arg, "--header"))
+      {
+        workbook.filter.header = true;
+        continue;
       } else {
         std::cerr << "Unrecognized switch: " << arg << std::endl;
         print_usage(std::cerr, argv[0]);
@@ -107,7 +195,7 @@ parse_args(struct sheet& sheet, int argc, char** argv)
               print_usage(std::cerr, argv[0]);
               std::exit(EXIT_FAILURE);
             }
-            sheet.separator = separator[0];
+            workbook.separator = separator[0];
           } else {
             std::cerr << "Argument expected for the -s option." << std::endl;
             print_usage(std::cerr, argv[0]);
@@ -115,6 +203,10 @@ parse_args(struct sheet& sheet, int argc, char** argv)
           }
           break;
 
+        case 'f':
+          follow = true;
+          break;
+
         case 'h':
           print_usage(std::cout, argv[0]);
           std::exit(EXIT_SUCCESS);
@@ -169,26 +261,63 @@ main(int argc, char** argv)
 {
   using peelo::unicode::encoding::utf8::encode;
 
-  struct sheet sheet;
+  struct workbook workbook;
+  std::vector<std::filesystem::path> filenames;
+  bool follow = false;
 
-  parse_args(sheet, argc, argv);
-  if (sheet.filename)
+  parse_args(workbook, filenames, follow, argc, argv);
+  if (filenames.empty())
   {
-    if (const auto error = sheet.load(*sheet.filename, sheet.separator))
+    workbook.add(U"Sheet1");
+  } else {
+    // Only the first sheet is loaded right away, rest of them are loaded
+    // when they are viewed or referenced for the first time.
+    for (const auto& filename : filenames)
+    {
+      if (filename == "-")
+      {
+        // Standard input is always followed, as it can't be read again.
+        if (const auto error = workbook.add(U"stdin").follow(std::nullopt))
+        {
+          std::cerr << encode(*error) << std::endl;
+
+          return EXIT_FAILURE;
+        }
+      } else {
+        workbook.add(filename.stem().u32string(), filename);
+      }
+    }
+    // First sheet is loaded progressively, so that the user interface can be
+    // shown before all of it has been parsed.
+    if (const auto error = workbook.load(workbook.entries[0], true))
     {
       std::cerr << encode(*error) << std::endl;
 
       return EXIT_FAILURE;
     }
+    if (follow && workbook.entries[0].sheet->filename)
+    {
+      auto& sheet = *workbook.entries[0].sheet;
+
+      if (const auto error = sheet.follow(sheet.filename))
+      {
+        std::cerr << encode(*error) << std::endl;
+
+        return EXIT_FAILURE;
+      }
+    }
   }
-  run_init(sheet);
+  run_init(*workbook.get_current().sheet);
   tb_init();
   tb_set_input_mode(TB_INPUT_ESC | TB_INPUT_MOUSE);
   tb_hide_cursor();
   for (;;)
   {
+    auto& sheet = *workbook.get_current().sheet;
+
     render(sheet);
-    handle_event(sheet);
+    handle_event(sheet, background::get_timeout(workbook));
+    background::poll(workbook);
   }
 
   return EXIT_SUCCESS;
@@ -54,7 +54,7 @@ evaluate(
 {
   if (const auto cell = sheet.get(coordinates))
   {
-    values.push_back(cell->evaluate(sheet.context));
+    values.push_back(sheet.evaluate(coordinates, *cell));
   }
 }
 
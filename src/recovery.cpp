@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "./csv.hpp"
+#include "./recovery.hpp"
+
+recovery_log::recovery_log()
+  : fd(-1)
+  , written(0)
+  , enabled(true)
+  , unsynced(false) {}
+
+recovery_log::~recovery_log()
+{
+  if (fd >= 0)
+  {
+    ::close(fd);
+  }
+}
+
+std::filesystem::path
+recovery_log::get_path(const std::filesystem::path& filename)
+{
+  return filename.parent_path() / (
+    "." + filename.filename().string() + ".recovery"
+  );
+}
+
+bool
+recovery_log::read(
+  const std::filesystem::path& filename,
+  std::vector<binary::change>& changes
+)
+{
+  csv::mapped_file file;
+
+  if (!file.open(get_path(filename)))
+  {
+    return false;
+  }
+  binary::read_changes(file.view(), changes);
+
+  return true;
+}
+
+void
+recovery_log::flush(const std::optional<std::filesystem::path>& filename)
+{
+  const auto now = std::chrono::steady_clock::now();
+
+  // Changes of sheets without a file can't be recovered.
+  if (!filename)
+  {
+    written = changes.length();
+    return;
+  }
+  // Start over when the sheet has been given another file.
+  if (fd >= 0 && path != get_path(*filename))
+  {
+    close_file(true);
+  }
+  if (fd < 0)
+  {
+    if (changes.empty())
+    {
+      return;
+    }
+    path = get_path(*filename);
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+    {
+      return;
+    }
+    written = 0;
+  }
+  if (written < changes.length())
+  {
+    if (!csv::write_all(fd, std::string_view(changes).substr(written)))
+    {
+      return;
+    }
+    written = changes.length();
+    unsynced = true;
+  }
+  if (unsynced && now - last_sync >= SYNC_INTERVAL)
+  {
+#if defined(__APPLE__)
+    // There is no fdatasync() on macOS.
+    fsync(fd);
+#else
+    fdatasync(fd);
+#endif
+    last_sync = now;
+    unsynced = false;
+  }
+}
+
+void
+recovery_log::drop(std::size_t count)
+{
+  changes.erase(0, count);
+  // Whatever is left replaces contents of the file on the next flush. Until
+  // then the file still holds all of it, along with changes already saved.
+  close_file(changes.empty());
+  written = 0;
+}
+
+void
+recovery_log::reset()
+{
+  changes.clear();
+  close_file(false);
+  written = 0;
+}
+
+void
+recovery_log::discard(const std::optional<std::filesystem::path>& filename)
+{
+  changes.clear();
+  close_file(true);
+  written = 0;
+  if (filename)
+  {
+    unlink(get_path(*filename).c_str());
+  }
+}
+
+void
+recovery_log::close_file(bool remove)
+{
+  if (fd >= 0)
+  {
+    ::close(fd);
+    fd = -1;
+    if (remove)
+    {
+      unlink(path.c_str());
+    }
+  }
+  unsynced = false;
+}
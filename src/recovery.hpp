@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "./binary.hpp"
+
+// Append-only log of changes made to a sheet since it was last saved. It is
+// kept in a hidden file next to the sheet's file, so that the changes can
+// be recovered after a crash.
+struct recovery_log
+{
+  // Minimum time between syncs of the file to disk.
+  static constexpr auto SYNC_INTERVAL = std::chrono::seconds(1);
+
+  std::filesystem::path path;
+  int fd;
+  // Changes since the sheet was last saved, encoded with
+  // binary::put_change(), and how many bytes of them are in the file.
+  std::string changes;
+  std::size_t written;
+  bool enabled;
+  bool unsynced;
+  std::chrono::steady_clock::time_point last_sync;
+
+  explicit recovery_log();
+  recovery_log(const recovery_log&) = delete;
+  recovery_log& operator=(const recovery_log&) = delete;
+  ~recovery_log();
+
+  static std::filesystem::path
+  get_path(const std::filesystem::path& filename);
+
+  // Reads changes left behind in the log of given file.
+  static bool
+  read(
+    const std::filesystem::path& filename,
+    std::vector<binary::change>& changes
+  );
+
+  inline void
+  record(const coordinates& coords, const laskin::value* value)
+  {
+    if (enabled)
+    {
+      binary::put_change(changes, coords, value);
+    }
+  }
+
+  inline bool
+  is_pending() const
+  {
+    return written < changes.length() || unsynced;
+  }
+
+  // Writes changes recorded since the last flush into the log of given
+  // file. The file is synced to disk at most once per SYNC_INTERVAL.
+  void
+  flush(const std::optional<std::filesystem::path>& filename);
+
+  // Forgets given number of bytes from the beginning of the changes, after
+  // they have been saved.
+  void
+  drop(std::size_t count);
+
+  // Forgets all changes, but leaves the file alone.
+  void
+  reset();
+
+  // Forgets all changes and removes the file, as well as the one left
+  // behind for given file.
+  void
+  discard(const std::optional<std::filesystem::path>& filename);
+
+  void
+  close_file(bool remove);
+};
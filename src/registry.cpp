@@ -25,6 +25,7 @@
  */
 #include "./registry.hpp"
 #include "./sheet.hpp"
+#include "./stats.hpp"
 
 namespace registry
 {
@@ -97,6 +98,7 @@ namespace registry
       return false;
     }
 
+    sheet.begin_batch();
     for (const auto& [offset, value] : it->second)
     {
       const coordinates target = { at.x + offset.x, at.y + offset.y };
@@ -106,7 +108,28 @@ namespace registry
         sheet.set(target, value);
       }
     }
+    sheet.commit();
 
     return true;
   }
+
+  struct usage
+  get_usage()
+  {
+    struct usage result = { registers.size(), 0, 0 };
+
+    result.bytes += registers.bucket_count() * sizeof(void*);
+    for (const auto& [name, e] : registers)
+    {
+      result.cells += e.size();
+      result.bytes += sizeof(name) + sizeof(e) + sizeof(void*);
+      result.bytes += (e.capacity() - e.size()) * sizeof(entry::value_type);
+      for (const auto& [offset, value] : e)
+      {
+        result.bytes += sizeof(offset) + stats::get_value_size(value);
+      }
+    }
+
+    return result;
+  }
 }
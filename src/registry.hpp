@@ -66,4 +66,14 @@ namespace registry
 
   bool
   is_valid_name(char32_t ch);
+
+  struct usage
+  {
+    std::size_t registers;
+    std::size_t cells;
+    std::size_t bytes;
+  };
+
+  struct usage
+  get_usage();
 }
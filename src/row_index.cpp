@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "./csv.hpp"
+#include "./row_index.hpp"
+
+static const std::string_view MAGIC("\x89LEVIDX\n", 8);
+
+static void
+put_uint(std::string& output, std::uint64_t value)
+{
+  for (int i = 0; i < 8; ++i)
+  {
+    output.append(1, static_cast<char>((value >> (i * 8)) & 0xff));
+  }
+}
+
+static std::uint64_t
+get_uint(const std::string_view& input, std::size_t& pos)
+{
+  std::uint64_t result = 0;
+
+  for (int i = 0; i < 8; ++i)
+  {
+    result |= static_cast<std::uint64_t>(
+      static_cast<unsigned char>(input[pos++])
+    ) << (i * 8);
+  }
+
+  return result;
+}
+
+std::filesystem::path
+row_index::get_path(const std::filesystem::path& filename)
+{
+  return filename.parent_path() / (
+    "." + filename.filename().string() + ".index"
+  );
+}
+
+void
+row_index::build(
+  const std::string_view& input,
+  std::uintmax_t size,
+  std::filesystem::file_time_type time,
+  char separator
+)
+{
+  std::size_t pos = 0;
+
+  this->size = size;
+  this->time = time;
+  this->separator = separator;
+  rows = 0;
+  offsets.clear();
+  while (pos < input.length())
+  {
+    const auto next = csv::skip_records(input, pos, INTERVAL, separator);
+
+    offsets.push_back(pos);
+    rows += INTERVAL;
+    if (next >= input.length())
+    {
+      // Count the rows of the last block one by one.
+      rows -= INTERVAL;
+      while (pos < input.length())
+      {
+        pos = csv::skip_records(input, pos, 1, separator);
+        ++rows;
+      }
+      break;
+    }
+    pos = next;
+  }
+}
+
+bool
+row_index::read(
+  const std::filesystem::path& filename,
+  std::uintmax_t size,
+  std::filesystem::file_time_type time,
+  char separator
+)
+{
+  csv::mapped_file file;
+  std::size_t pos = MAGIC.length();
+
+  if (!file.open(get_path(filename)))
+  {
+    return false;
+  }
+
+  const auto input = file.view();
+
+  if (input.length() < MAGIC.length() + 40 || input.compare(0, 8, MAGIC))
+  {
+    return false;
+  }
+  else if (
+    get_uint(input, pos) != size ||
+    static_cast<std::int64_t>(get_uint(input, pos)) !=
+      time.time_since_epoch().count() ||
+    get_uint(input, pos) != INTERVAL ||
+    get_uint(input, pos) != static_cast<unsigned char>(separator)
+  )
+  {
+    return false;
+  }
+  rows = get_uint(input, pos);
+
+  // There has to be an offset for every started block of rows. The count is
+  // compared against the number of offsets, which can't overflow, as it may
+  // come from a corrupted file.
+  const auto blocks = (input.length() - pos) / 8;
+
+  if (
+    (input.length() - pos) % 8 != 0 ||
+    rows > blocks * INTERVAL ||
+    (blocks > 0 && rows <= (blocks - 1) * INTERVAL)
+  )
+  {
+    return false;
+  }
+  offsets.clear();
+  while (pos < input.length())
+  {
+    offsets.push_back(get_uint(input, pos));
+  }
+  this->size = size;
+  this->time = time;
+  this->separator = separator;
+
+  return true;
+}
+
+bool
+row_index::write(const std::filesystem::path& filename) const
+{
+  csv::output_file file;
+  std::string output(MAGIC);
+
+  put_uint(output, size);
+  put_uint(output, time.time_since_epoch().count());
+  put_uint(output, INTERVAL);
+  put_uint(output, static_cast<unsigned char>(separator));
+  put_uint(output, rows);
+  for (const auto offset : offsets)
+  {
+    put_uint(output, offset);
+  }
+
+  return (
+    file.open(get_path(filename)) &&
+    file.write(output) &&
+    file.commit()
+  );
+}
+
+std::size_t
+row_index::find(const std::string_view& input, std::size_t row) const
+{
+  const auto block = row / INTERVAL;
+
+  if (block >= offsets.size())
+  {
+    return input.length();
+  }
+
+  return csv::skip_records(input, offsets[block], row % INTERVAL, separator);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+// Sparse index of byte offsets of rows in a CSV file, so that a range of
+// rows can be loaded without parsing everything before them. It is kept in
+// a hidden file next to the CSV file, and is valid as long as size and
+// modification time of the CSV file stay the same, and the file is read with
+// the same field separator.
+struct row_index
+{
+  // Number of rows between offsets stored in the index.
+  static constexpr std::size_t INTERVAL = 1024;
+
+  std::uintmax_t size;
+  std::filesystem::file_time_type time;
+  char separator;
+  // Total number of rows and offset of every INTERVAL:th row.
+  std::size_t rows;
+  std::vector<std::uint64_t> offsets;
+
+  static std::filesystem::path
+  get_path(const std::filesystem::path& filename);
+
+  // Indexes given CSV data, read from a file with given size, modification
+  // time and field separator.
+  void
+  build(
+    const std::string_view& input,
+    std::uintmax_t size,
+    std::filesystem::file_time_type time,
+    char separator
+  );
+
+  // Reads index of given file, if one exists and matches the file.
+  bool
+  read(
+    const std::filesystem::path& filename,
+    std::uintmax_t size,
+    std::filesystem::file_time_type time,
+    char separator
+  );
+
+  // Writes the index next to given file.
+  bool
+  write(const std::filesystem::path& filename) const;
+
+  // Returns position of given row in the indexed data.
+  std::size_t
+  find(const std::string_view& input, std::size_t row) const;
+};
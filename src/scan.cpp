@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+#endif
+
+#include "./scan.hpp"
+
+namespace scan
+{
+  using function_type = const char* (*)(const char*, const char*, char);
+
+  static inline bool
+  is_special(char c, char separator)
+  {
+    return c == separator || c == '"' || c == '\r' || c == '\n';
+  }
+
+  static const char*
+  find_special_scalar(const char* begin, const char* end, char separator)
+  {
+    while (begin < end && !is_special(*begin, separator))
+    {
+      ++begin;
+    }
+
+    return begin;
+  }
+
+#if defined(__SSE2__)
+  static const char*
+  find_special_sse2(const char* begin, const char* end, char separator)
+  {
+    const auto s = _mm_set1_epi8(separator);
+    const auto q = _mm_set1_epi8('"');
+    const auto cr = _mm_set1_epi8('\r');
+    const auto lf = _mm_set1_epi8('\n');
+
+    while (end - begin >= 16)
+    {
+      const auto chunk = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(begin)
+      );
+      const auto mask = _mm_movemask_epi8(
+        _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(chunk, s), _mm_cmpeq_epi8(chunk, q)),
+          _mm_or_si128(_mm_cmpeq_epi8(chunk, cr), _mm_cmpeq_epi8(chunk, lf))
+        )
+      );
+
+      if (mask)
+      {
+        return begin + __builtin_ctz(mask);
+      }
+      begin += 16;
+    }
+
+    return find_special_scalar(begin, end, separator);
+  }
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+  __attribute__((target("avx2")))
+  static const char*
+  find_special_avx2(const char* begin, const char* end, char separator)
+  {
+    const auto s = _mm256_set1_epi8(separator);
+    const auto q = _mm256_set1_epi8('"');
+    const auto cr = _mm256_set1_epi8('\r');
+    const auto lf = _mm256_set1_epi8('\n');
+
+    while (end - begin >= 32)
+    {
+      const auto chunk = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(begin)
+      );
+      const auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(
+        _mm256_or_si256(
+          _mm256_or_si256(
+            _mm256_cmpeq_epi8(chunk, s),
+            _mm256_cmpeq_epi8(chunk, q)
+          ),
+          _mm256_or_si256(
+            _mm256_cmpeq_epi8(chunk, cr),
+            _mm256_cmpeq_epi8(chunk, lf)
+          )
+        )
+      ));
+
+      if (mask)
+      {
+        return begin + __builtin_ctz(mask);
+      }
+      begin += 32;
+    }
+
+    return find_special_scalar(begin, end, separator);
+  }
+#endif
+
+  static function_type
+  select_implementation()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+      return find_special_avx2;
+    }
+#endif
+#if defined(__SSE2__)
+    return find_special_sse2;
+#else
+    return find_special_scalar;
+#endif
+  }
+
+  const char*
+  find_special(const char* begin, const char* end, char separator)
+  {
+    static const auto implementation = select_implementation();
+
+    return implementation(begin, end, separator);
+  }
+
+  std::vector<implementation>
+  implementations()
+  {
+    std::vector<implementation> result = {
+      { "scalar", find_special_scalar },
+    };
+
+#if defined(__SSE2__)
+    result.push_back({ "sse2", find_special_sse2 });
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+      result.push_back({ "avx2", find_special_avx2 });
+    }
+#endif
+
+    return result;
+  }
+}
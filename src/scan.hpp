@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+namespace scan
+{
+  // Returns pointer to the first byte in given range which is either the
+  // separator, a double quote, a carriage return or a line feed, or `end`
+  // if there are no such bytes. Uses AVX2 or SSE2 when the CPU supports
+  // them, selected at runtime, and falls back to a scalar loop otherwise.
+  const char*
+  find_special(const char* begin, const char* end, char separator);
+
+  struct implementation
+  {
+    const char* name;
+    const char* (*find_special)(const char*, const char*, char);
+  };
+
+  // Returns all implementations of find_special() the CPU supports, for
+  // comparing them against each other.
+  std::vector<implementation>
+  implementations();
+
+  inline bool
+  needs_quoting(const std::string_view& input, char separator)
+  {
+    const auto end = input.data() + input.length();
+
+    return find_special(input.data(), end, separator) != end;
+  }
+}
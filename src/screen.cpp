@@ -28,10 +28,12 @@
 
 #include <peelo/unicode/encoding/utf8.hpp>
 
+#include "./background.hpp"
 #include "./input.hpp"
 #include "./screen.hpp"
 #include "./setting.hpp"
 #include "./termbox2.h"
+#include "./workbook.hpp"
 
 static int xtop;
 static int xleft;
@@ -255,8 +257,15 @@ render_status(struct sheet& sheet)
   using peelo::unicode::encoding::utf8::encode;
 
   const auto height = tb_height();
-  const auto name = encode(cursor.to_string());
+  auto name = encode(cursor.to_string());
   const auto cell = sheet.get(cursor);
+  const auto error = sheet.get_error(cursor);
+  const auto status = background::get_status(sheet);
+
+  if (sheet.workbook && sheet.workbook->entries.size() > 1)
+  {
+    name = encode(sheet.workbook->get_current().name) + "!" + name;
+  }
 
   if (
     current_mode == mode::insert ||
@@ -312,23 +321,33 @@ render_status(struct sheet& sheet)
     height - 2,
     setting::get_int(setting::key::status_foreground),
     setting::get_int(setting::key::status_background),
-    (cell && cell->error ? *cell->error : encode(message)).c_str()
+    (
+      error ? *error :
+      status ? encode(*status) :
+      !message.empty() || !sheet.sample_population ? encode(message) :
+      "Random sample of " +
+        std::to_string(sheet.sample_size) +
+        " of " +
+        std::to_string(*sheet.sample_population) +
+        " rows"
+    ).c_str()
   );
 }
 
 static void
 render_cell(
+  struct sheet& sheet,
+  const coordinates& coords,
   const struct cell& cell,
-  laskin::context& context,
   bool& cursor_rendered
 )
 {
   using peelo::unicode::encoding::utf8::encode;
 
   const auto cell_width = setting::get_int(setting::key::cell_width);
-  const auto is_cursor = cell.coordinates == cursor;
-  const auto is_selected = is_in_selection(cell.coordinates);
-  auto value = cell.evaluate(context);
+  const auto is_cursor = coords == cursor;
+  const auto is_selected = is_in_selection(coords);
+  auto value = sheet.evaluate(coords, cell);
   std::u32string result;
 
   if (value.is(laskin::value::type::string))
@@ -355,8 +374,8 @@ render_cell(
   }
 
   tb_print(
-    (cell_width * (cell.coordinates.x - xleft)) + 3,
-    cell.coordinates.y - xtop + 1,
+    (cell_width * (coords.x - xleft)) + 3,
+    coords.y - xtop + 1,
     setting::get_int(
       is_cursor   ? setting::key::cursor_foreground :
       is_selected ? setting::key::selection_foreground :
@@ -394,9 +413,20 @@ render_sheet(struct sheet& sheet)
     {
       const coordinates coords = { x + xleft, y + xtop };
 
-      if (const auto cell = sheet.get(coords))
+      // Rows that are still being loaded are not waited for.
+      if (coords.y >= sheet.loaded_rows)
+      {
+        tb_print(
+          (x * cell_width) + 3,
+          y + 1,
+          cell_foreground,
+          cell_background,
+          (std::string(cell_width - 1, ' ') + "~").c_str()
+        );
+      }
+      else if (const auto cell = sheet.get(coords))
       {
-        render_cell(*cell, sheet.context, cursor_rendered);
+        render_cell(sheet, coords, *cell, cursor_rendered);
       } else {
         const auto selected = is_in_selection(coords);
 
@@ -37,6 +37,7 @@ namespace setting
 {
   enum class type
   {
+    boolean,
     color,
     number,
     string,
@@ -54,6 +55,9 @@ namespace setting
 
       switch (type)
       {
+        case type::boolean:
+          return std::get<int>(value) ? U"true" : U"false";
+
         case type::color:
           return color::get_name(std::get<int>(value));
 
@@ -74,6 +78,21 @@ namespace setting
 
       switch (type)
       {
+        case type::boolean:
+          if (!new_value.compare(U"true"))
+          {
+            value = 1;
+
+            return true;
+          }
+          else if (!new_value.compare(U"false"))
+          {
+            value = 0;
+
+            return true;
+          }
+          break;
+
         case type::color:
           if (const auto color = color::find_by_name(new_value))
           {
@@ -110,32 +129,42 @@ namespace setting
 
   static std::unordered_map<key, variable> mapping =
   {
+    { key::auto_reload, { type::boolean, 0 } },
     { key::background, { type::color, TB_GREEN } },
     { key::cell_background, { type::color, TB_DEFAULT } },
     { key::cell_foreground, { type::color, TB_GREEN } },
     { key::cell_width, { type::number, 10 } },
+    { key::compression_level, { type::number, 6 } },
     { key::cursor_background, { type::color, TB_GREEN | TB_BRIGHT } },
     { key::cursor_foreground, { type::color, TB_BLACK } },
+    { key::follow_scroll, { type::boolean, 1 } },
     { key::foreground, { type::color, TB_BLACK } },
+    { key::lazy_types, { type::boolean, 1 } },
     { key::selection_background, { type::color, TB_GREEN } },
     { key::selection_foreground, { type::color, TB_BLACK } },
     { key::status_background, { type::color, TB_DEFAULT } },
     { key::status_foreground, { type::color, TB_DEFAULT } },
+    { key::undo_limit, { type::number, 10240 } },
   };
 
   static const std::unordered_map<std::u32string, key> name_mapping =
   {
+    { U"auto-reload", key::auto_reload },
     { U"background", key::background },
     { U"cell-background", key::cell_background },
     { U"cell-foreground", key::cell_foreground },
     { U"cell-width", key::cell_width },
+    { U"compression-level", key::compression_level },
     { U"cursor-background", key::cursor_background },
     { U"cursor-foreground", key::cursor_foreground },
+    { U"follow-scroll", key::follow_scroll },
     { U"foreground", key::foreground },
+    { U"lazy-types", key::lazy_types },
     { U"selection-background", key::selection_background },
     { U"selection-foreground", key::selection_foreground },
     { U"status-background", key::status_background },
     { U"status-foreground", key::status_foreground },
+    { U"undo-limit", key::undo_limit },
   };
 
   static std::optional<key>
@@ -32,17 +32,22 @@ namespace setting
 {
   enum class key
   {
+    auto_reload,
     background,
     cell_background,
     cell_foreground,
     cell_width,
+    compression_level,
     cursor_background,
     cursor_foreground,
+    follow_scroll,
     foreground,
+    lazy_types,
     selection_background,
     selection_foreground,
     status_background,
     status_foreground,
+    undo_limit,
   };
 
   int
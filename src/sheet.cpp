@@ -24,247 +24,2258 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
 
 #include <laskin/chrono.hpp>
 #include <laskin/error.hpp>
 #include <laskin/value.hpp>
 #include <peelo/unicode/encoding/utf8.hpp>
-#include <rapidcsv.h>
 
+#include "./binary.hpp"
+#include "./csv.hpp"
+#include "./follow.hpp"
+#include "./gzip.hpp"
 #include "./range.hpp"
-#include "./sheet.hpp"
+#include "./row_index.hpp"
+#include "./setting.hpp"
+#include "./utils.hpp"
+#include "./workbook.hpp"
 
 sheet::sheet()
-  : modified(false)
+  : workbook(nullptr)
+  , modified(false)
   , separator(',')
   , context(
-    [this](const std::u32string& name) -> std::optional<laskin::value>
+    [this](const std::u32string& name)
     {
-      using peelo::unicode::encoding::utf8::encode;
+      return this->lookup(name);
+    },
+    false
+  )
+  , row_counts()
+  , column_counts()
+  , max_row(0)
+  , max_col(0)
+  , version(0)
+  , batch_depth(0)
+  , batch_changes(0)
+  , results_generation(0)
+  , binary_size(0)
+  , binary_changes_size(0)
+  , loaded_rows(coordinates::MAX_Y)
+  , loaded_size(0)
+  , followed_rows(-1)
+  , followed_partial_row(false)
+  , sample_size(0) {}
+
+void
+sheet::set(const coordinates& coords, const laskin::value& value)
+{
+  if (!coords.is_valid())
+  {
+    return;
+  }
+
+  std::optional<laskin::value> before;
+
+  // A row still being loaded would otherwise overwrite the new value once
+  // it arrives.
+  if (coords.y >= loaded_rows)
+  {
+    continue_loading(coords.y);
+  }
+
+  // The old value is about to be overwritten, so it can be moved into the
+  // journal instead of being copied.
+  if (const auto cell = grid.find_for_update(coords))
+  {
+    if (cell->raw)
+    {
+      before = parse_value(cell->value.as_string());
+    } else {
+      before = std::move(cell->value);
+    }
+  }
+  store(coords, value);
+  journal.record(coords, std::move(before), value);
+}
+
+void
+sheet::store(const coordinates& coords, const laskin::value& value, bool raw)
+{
+  recovery.record(coords, &value);
+  if (grid.insert_or_assign(coords, value, raw))
+  {
+    if (row_counts[coords.y]++ == 0)
+    {
+      max_row = std::max(max_row, coords.y + 1);
+    }
+    if (column_counts[coords.x]++ == 0)
+    {
+      max_col = std::max(max_col, coords.x + 1);
+    }
+  }
+  touch();
+}
+
+// Decides type of a cell loaded from a file. The result replaces the original
+// text, but isn't considered to be a change to the sheet.
+const cell*
+sheet::classify(const coordinates& coords)
+{
+  const auto cell = grid.find_for_update(coords);
+
+  if (cell && cell->raw)
+  {
+    cell->value = parse_value(cell->value.as_string());
+    cell->raw = false;
+  }
+
+  return cell;
+}
+
+laskin::value
+sheet::evaluate(const coordinates& coords, const cell& cell)
+{
+  if (!results.empty())
+  {
+    if (results_generation == get_generation())
+    {
+      const auto it = results.find(coords);
+
+      if (it != std::end(results))
+      {
+        return it->second;
+      }
+    } else {
+      results.clear();
+    }
+  }
+
+  try
+  {
+    return cell.evaluate(context);
+  }
+  catch (const laskin::error& e)
+  {
+    errors[coords] = e.message;
+
+    return laskin::value(U"#ERROR");
+  }
+}
+
+struct snapshot
+sheet::take_snapshot(const std::optional<std::filesystem::path>& destination)
+{
+  finish_loading();
+
+  struct snapshot snapshot = {
+    grid,
+    max_row,
+    max_col,
+    version,
+    {},
+    recovery.changes,
+    false,
+    setting::get_int(setting::key::compression_level)
+  };
+  std::error_code ec;
+
+  if (!destination || !binary::is_binary_path(*destination))
+  {
+    return snapshot;
+  }
+
+  // Changes can be appended to the binary file this sheet was loaded from
+  // or saved into, as long as it hasn't been touched by anyone else. Once
+  // they would take more than half of the file, it is compacted by writing
+  // it again.
+  snapshot.incremental = (
+    binary_path == destination &&
+    std::filesystem::file_size(*destination, ec) ==
+      binary_size + binary_changes_size &&
+    !ec &&
+    binary_changes_size + snapshot.changes.length() + 8 <= binary_size / 2
+  );
+
+  // Formulas can only be evaluated on this thread, so their results are
+  // included in the snapshot up front.
+  if (!snapshot.incremental)
+  {
+    std::vector<std::pair<coordinates, const struct cell*>> formulas;
+
+    // Cells of the snapshot stay put even if evaluation of the formulas
+    // updates the grid.
+    snapshot.grid.for_each(
+      [&formulas](const coordinates& coords, const cell& cell)
+      {
+        if (cell.is_formula())
+        {
+          formulas.emplace_back(coords, &cell);
+        }
+      }
+    );
+    for (const auto& [coords, cell] : formulas)
+    {
+      try
+      {
+        snapshot.results.emplace(coords, cell->evaluate(context));
+      }
+      catch (const laskin::error&) {}
+    }
+  }
+
+  return snapshot;
+}
+
+void
+sheet::saved(
+  const struct snapshot& snapshot,
+  const std::filesystem::path& path,
+  std::vector<std::uint64_t>&& hashes
+)
+{
+  std::error_code ec;
+
+  // Changes made while the file was being written are not in it.
+  if (version == snapshot.version)
+  {
+    modified = false;
+  }
+  recovery.drop(snapshot.changes.length());
+  if (path == filename)
+  {
+    loaded_size = std::filesystem::file_size(path, ec);
+    loaded_time = std::filesystem::last_write_time(path, ec);
+    row_hashes = std::move(hashes);
+  }
+  if (!binary::is_binary_path(path))
+  {
+    binary_path.reset();
+    return;
+  }
+
+  const auto size = std::filesystem::file_size(path, ec);
+
+  if (ec)
+  {
+    binary_path.reset();
+  }
+  else if (snapshot.incremental)
+  {
+    binary_changes_size = size - binary_size;
+  } else {
+    binary_path = path;
+    binary_size = size;
+    binary_changes_size = 0;
+  }
+}
+
+std::size_t
+sheet::recover()
+{
+  std::vector<binary::change> changes;
+
+  const auto recovery_filename = get_recovery_filename();
+
+  if (!recovery_filename || !recovery_log::read(*recovery_filename, changes))
+  {
+    return 0;
+  }
+  finish_loading();
+  begin_batch();
+  for (const auto& change : changes)
+  {
+    if (!change.coordinates.is_valid())
+    {
+      continue;
+    }
+    else if (change.value)
+    {
+      set(change.coordinates, *change.value);
+    } else {
+      erase(change.coordinates);
+    }
+  }
+  commit();
+
+  return changes.size();
+}
+
+unsigned long
+sheet::get_generation() const
+{
+  return workbook ? workbook->get_generation() : version;
+}
+
+std::optional<laskin::value>
+sheet::lookup(const std::u32string& name)
+{
+  const auto index = name.find(U'!');
+
+  // Sheet2!A1
+  if (index != std::u32string::npos)
+  {
+    if (workbook)
+    {
+      if (const auto other = workbook->find(name.substr(0, index)))
+      {
+        return other->lookup(name.substr(index + 1));
+      }
+    }
+  }
+  else if (const auto range = range::parse(name))
+  {
+    if (const auto values = range->extract(*this))
+    {
+      return *values;
+    }
+  }
+  else if (const auto coords = coordinates::parse(name))
+  {
+    if (const auto cell = get(*coords))
+    {
+      return evaluate(*coords, *cell);
+    }
+  }
+
+  return std::nullopt;
+}
+
+// Decides type of the value with a single pass over the input, so that only
+// the parsers which could possibly accept it are tried.
+laskin::value
+sheet::parse_value(const std::u32string& input)
+{
+  const auto length = input.length();
+
+  if (input.empty() || input[0] == U'=')
+  {
+    return laskin::value(input);
+  }
+
+  const auto first = input[0];
+
+  if (
+    (first >= U'0' && first <= U'9') ||
+    first == U'-' ||
+    first == U'+' ||
+    first == U'.'
+  )
+  {
+    std::size_t digits = 0;
+    std::size_t dots = 0;
+    char32_t stop = 0;
+
+    for (std::size_t i = first == U'-' ? 1 : 0; i < length; ++i)
+    {
+      const auto c = input[i];
+
+      if (c >= U'0' && c <= U'9')
+      {
+        ++digits;
+      }
+      else if (c == U'.' && digits > 0 && dots == 0)
+      {
+        ++dots;
+      } else {
+        stop = c;
+        break;
+      }
+    }
+
+    // Plain integers and decimals such as `-12` or `3.14` are always valid
+    // numbers, so there is no need to validate them separately.
+    if (!stop && digits > 0 && input.back() != U'.')
+    {
+      return laskin::value::parse_number(input);
+    }
+    // Digits followed by a dash or a colon can't be a number, but might be
+    // a date such as `2024-01-31` or a time such as `12:30:00`.
+    else if (first != U'-' && dots == 0 && digits > 0 && stop == U'-')
+    {
+      if (laskin::is_date(input))
+      {
+        return laskin::parse_date(input);
+      }
+
+      return laskin::value(input);
+    }
+    else if (first != U'-' && dots == 0 && digits > 0 && stop == U':')
+    {
+      if (laskin::is_time(input))
+      {
+        return laskin::parse_time(input);
+      }
+
+      return laskin::value(input);
+    }
+    else if (peelo::number::is_valid(input))
+    {
+      return laskin::value::parse_number(input);
+    }
+    else if (laskin::is_date(input))
+    {
+      return laskin::parse_date(input);
+    }
+    else if (laskin::is_time(input))
+    {
+      return laskin::parse_time(input);
+    }
+
+    return laskin::value(input);
+  }
+
+  // Only words can be names of months, weekdays or booleans.
+  if (!input.compare(U"true"))
+  {
+    return true;
+  }
+  else if (!input.compare(U"false"))
+  {
+    return false;
+  }
+  else if (laskin::is_month(input))
+  {
+    return laskin::parse_month(input);
+  }
+  else if (laskin::is_weekday(input))
+  {
+    return laskin::parse_weekday(input);
+  }
+
+  return laskin::value(input);
+}
+
+void
+sheet::erase(const coordinates& coords)
+{
+  // Make sure that undo restores the cell with the type it would have had.
+  get(coords);
+  if (auto value = remove(coords))
+  {
+    journal.record(coords, std::move(value), std::nullopt);
+  }
+}
+
+std::optional<laskin::value>
+sheet::remove(const coordinates& coords)
+{
+  auto value = grid.erase(coords);
+
+  if (!value)
+  {
+    return std::nullopt;
+  }
+  recovery.record(coords, nullptr);
+  --row_counts[coords.y];
+  --column_counts[coords.x];
+  touch();
+
+  return value;
+}
+
+void
+sheet::clear()
+{
+  ++version;
+  grid.clear();
+  errors.clear();
+  results.clear();
+  row_counts.fill(0);
+  column_counts.fill(0);
+  max_row = 0;
+  max_col = 0;
+  journal.clear();
+}
+
+void
+sheet::begin_batch()
+{
+  ++batch_depth;
+  journal.begin();
+}
+
+void
+sheet::commit()
+{
+  if (batch_depth == 0)
+  {
+    return;
+  }
+  journal.commit();
+  if (--batch_depth == 0 && batch_changes > 0)
+  {
+    batch_changes = 0;
+    ++version;
+    modified = true;
+    shrink_extent();
+  }
+}
+
+void
+sheet::touch()
+{
+  if (batch_depth > 0)
+  {
+    ++batch_changes;
+  } else {
+    ++version;
+    modified = true;
+    shrink_extent();
+  }
+}
+
+void
+sheet::shrink_extent()
+{
+  while (max_row > 0 && row_counts[max_row - 1] == 0)
+  {
+    --max_row;
+  }
+  while (max_col > 0 && column_counts[max_col - 1] == 0)
+  {
+    --max_col;
+  }
+}
+
+std::optional<coordinates>
+sheet::undo()
+{
+  if (journal.undo_stack.empty())
+  {
+    return std::nullopt;
+  }
+
+  auto entry = std::move(journal.undo_stack.back());
+  const auto coords = entry.front().coordinates;
+
+  journal.undo_stack.pop_back();
+  begin_batch();
+  for (auto it = std::rbegin(entry); it != std::rend(entry); ++it)
+  {
+    if (it->before)
+    {
+      store(it->coordinates, *it->before);
+    } else {
+      remove(it->coordinates);
+    }
+  }
+  commit();
+  journal.redo_stack.push_back(std::move(entry));
+
+  return coords;
+}
+
+std::optional<coordinates>
+sheet::redo()
+{
+  if (journal.redo_stack.empty())
+  {
+    return std::nullopt;
+  }
+
+  auto entry = std::move(journal.redo_stack.back());
+  const auto coords = entry.front().coordinates;
+
+  journal.redo_stack.pop_back();
+  begin_batch();
+  for (const auto& change : entry)
+  {
+    if (change.after)
+    {
+      store(change.coordinates, *change.after);
+    } else {
+      remove(change.coordinates);
+    }
+  }
+  commit();
+  journal.undo_stack.push_back(std::move(entry));
+
+  return coords;
+}
+
+bool
+sheet::join(const coordinates& c1, const coordinates& c2)
+{
+  if (c1.is_valid() && c2.is_valid())
+  {
+    const auto cell1 = get(c1);
+    const auto cell2 = get(c2);
+
+    if (cell1 && cell2)
+    {
+      const auto value1 = evaluate(c1, *cell1);
+      const auto value2 = evaluate(c2, *cell2);
+      laskin::value result;
+
+      try
+      {
+        result = value1 + value2;
+      }
+      catch (const laskin::error& e)
+      {
+        return false;
+      }
+      begin_batch();
+      set(c1, result);
+      erase(c2);
+      commit();
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Parses column letters such as `C` or `AF` into index of the column, which
+// unlike coordinates can be past the last column of a sheet.
+static std::optional<std::size_t>
+parse_column(const std::u32string& input)
+{
+  std::size_t result = 0;
+
+  if (input.empty() || input.length() > 4)
+  {
+    return std::nullopt;
+  }
+  for (const auto c : input)
+  {
+    if (c < U'A' || c > U'Z')
+    {
+      return std::nullopt;
+    }
+    result = result * 26 + (c - U'A' + 1);
+  }
+
+  return result - 1;
+}
+
+bool
+load_filter::parse_columns(const std::string& input)
+{
+  using peelo::unicode::encoding::utf8::decode;
+
+  std::vector<std::size_t> result;
+  std::size_t start = 0;
+
+  for (;;)
+  {
+    const auto end = input.find(',', start);
+    auto name = utils::trim(decode(input.substr(start, end - start)));
+
+    for (auto& c : name)
+    {
+      if (c >= U'a' && c <= U'z')
+      {
+        c -= U'a' - U'A';
+      }
+    }
+    if (const auto column = parse_column(name))
+    {
+      result.push_back(*column);
+    } else {
+      return false;
+    }
+    if (end == std::string::npos)
+    {
+      break;
+    }
+    start = end + 1;
+  }
+  columns = result;
+
+  return true;
+}
+
+// Decides which rows and columns of a CSV file are loaded while it's being
+// parsed, so that nothing is stored for the rest of them.
+struct row_filter
+{
+  // Column of the sheet each column of the file goes into, or -1 if it's
+  // not loaded. Columns are kept where they are when this is empty.
+  std::vector<int> columns;
+  std::optional<laskin::quote> where;
+  laskin::context context;
+  // Fields of the row being parsed, for evaluating the predicate.
+  std::vector<std::string> fields;
+  std::size_t field_count;
+  std::u32string field;
+  std::string scratch;
+
+  explicit row_filter()
+    : context(
+      [this](const std::u32string& name)
+      {
+        return lookup(name);
+      },
+      false
+    )
+    , field_count(0) {}
+
+  std::optional<std::u32string>
+  compile(const struct load_filter& filter)
+  {
+    using peelo::unicode::encoding::utf8::decode;
+
+    if (filter.columns.size() > coordinates::MAX_X)
+    {
+      return U"Too many columns.";
+    }
+    for (std::size_t i = 0; i < filter.columns.size(); ++i)
+    {
+      const auto column = filter.columns[i];
+
+      if (column >= columns.size())
+      {
+        columns.resize(column + 1, -1);
+      }
+      columns[column] = i;
+    }
+    if (!filter.where.empty())
+    {
+      try
+      {
+        where = laskin::quote::parse(filter.where);
+      }
+      catch (const laskin::error& e)
+      {
+        return decode(e.message);
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  inline bool
+  is_active() const
+  {
+    return !columns.empty() || where;
+  }
+
+  // Returns the column of the sheet given column of the file goes into.
+  inline int
+  get_column(std::size_t column) const
+  {
+    if (columns.empty())
+    {
+      return column;
+    }
+
+    return column < columns.size() ? columns[column] : -1;
+  }
+
+  void
+  add(std::size_t column, const std::string_view& value)
+  {
+    if (column >= fields.size())
+    {
+      fields.resize(column + 1);
+    }
+    fields[column].assign(value);
+    field_count = column + 1;
+  }
+
+  // Tests whether given record satisfies the predicate.
+  bool
+  matches(const std::string_view& record, char separator)
+  {
+    bool result;
+
+    csv::parse(
+      record,
+      separator,
+      scratch,
+      [this](std::size_t column, const std::string_view& value)
+      {
+        add(column, value);
+
+        return true;
+      },
+      []()
+      {
+        return false;
+      }
+    );
+    result = accept();
+    field_count = 0;
+
+    return result;
+  }
+
+  // Tests whether the row collected with add() satisfies the predicate.
+  bool
+  accept()
+  {
+    try
+    {
+      context.clear();
+      where->call(context);
+
+      const auto result = context.pop();
+
+      return result.is(laskin::value::type::boolean) && result.as_boolean();
+    }
+    catch (const laskin::error&)
+    {
+      // Rows for which the predicate can't be evaluated are left out.
+      return false;
+    }
+  }
+
+  std::optional<laskin::value>
+  lookup(const std::u32string& name)
+  {
+    const auto column = parse_column(name);
+
+    if (!column || *column >= field_count)
+    {
+      return std::nullopt;
+    }
+    utils::decode_utf8(fields[*column], field);
+
+    return sheet::parse_value(field);
+  }
+};
+
+// Files larger than this are parsed in parallel.
+static constexpr std::size_t PARALLEL_LOAD_THRESHOLD = 1 << 20;
+
+// Parses rows of CSV data into cells given to the callback. Hashes of the
+// records, as csv::hash_records() would return them, are appended into
+// `hashes` if given.
+template<class Callback>
+static std::optional<std::u32string>
+parse_chunk(
+  const std::string_view& input,
+  char separator,
+  bool lazy,
+  int& row,
+  Callback callback,
+  int row_limit = coordinates::MAX_Y + 1,
+  std::size_t* end = nullptr,
+  row_filter* filter = nullptr,
+  std::vector<std::uint64_t>* hashes = nullptr
+)
+{
+  std::optional<std::u32string> error;
+  std::string scratch;
+  std::u32string field;
+  std::size_t pos;
+  auto hash = csv::EMPTY_RECORD_HASH;
+  const auto put = [&](std::size_t column, const std::string_view& value)
+  {
+    const int x = filter
+      ? filter->get_column(column)
+      : static_cast<int>(column);
+
+    if (row >= coordinates::MAX_Y)
+    {
+      error = U"Spreadsheet too long.";
+
+      return false;
+    }
+    else if (x < 0)
+    {
+      return true;
+    }
+    else if (x >= coordinates::MAX_X)
+    {
+      error = U"Spreadsheet too wide.";
+
+      return false;
+    }
+    else if (!value.empty())
+    {
+      utils::decode_utf8(value, field);
+      callback(
+        coordinates{ x, row },
+        lazy ? laskin::value(field) : sheet::parse_value(field)
+      );
+    }
+
+    return true;
+  };
+
+  pos = csv::parse(
+    input,
+    separator,
+    scratch,
+    [&](std::size_t column, const std::string_view& value)
+    {
+      if (hashes && !value.empty())
+      {
+        hash = csv::hash_field(hash, column, value);
+      }
+      // Fields are stored only once the whole row has been accepted.
+      if (filter && filter->where)
+      {
+        filter->add(column, value);
+
+        return true;
+      }
+
+      return put(column, value);
+    },
+    [&]()
+    {
+      if (hashes)
+      {
+        hashes->push_back(hash);
+        hash = csv::EMPTY_RECORD_HASH;
+      }
+      if (filter && filter->where)
+      {
+        const auto accepted = filter->accept();
+
+        for (std::size_t i = 0; accepted && i < filter->field_count; ++i)
+        {
+          if (!put(i, filter->fields[i]))
+          {
+            return false;
+          }
+        }
+        filter->field_count = 0;
+        if (!accepted)
+        {
+          return true;
+        }
+      }
+
+      return ++row < row_limit;
+    }
+  );
+  if (end)
+  {
+    *end = pos;
+  }
+
+  return error;
+}
+
+struct parsed_chunk
+{
+  std::vector<std::pair<coordinates, laskin::value>> cells;
+  std::vector<std::uint64_t> hashes;
+  int rows = 0;
+  std::optional<std::u32string> error;
+};
+
+// Files larger than this are loaded progressively when requested.
+static constexpr std::size_t PROGRESSIVE_LOAD_THRESHOLD = 1 << 18;
+
+// Number of rows loaded before a progressive load continues in background.
+static constexpr int INITIAL_ROWS = 128;
+
+// Number of rows parsed at a time by a progressive load.
+static constexpr int BLOCK_ROWS = 64;
+
+// Rest of a file being parsed on a background thread. Blocks of parsed rows
+// are queued for the main thread, which stores them into the grid.
+struct background_load
+{
+  csv::mapped_file file;
+  // Rows picked from a compressed file, used instead of the mapping.
+  std::string buffer;
+  std::size_t total;
+  std::atomic<std::size_t> parsed;
+  bool lazy;
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<parsed_chunk> queue;
+  bool done;
+  std::atomic<bool> cancelled;
+
+  ~background_load()
+  {
+    cancelled = true;
+    if (thread.joinable())
+    {
+      thread.join();
+    }
+  }
+
+  void
+  run(std::string_view input, char separator, int row)
+  {
+    while (!input.empty() && !cancelled)
+    {
+      parsed_chunk chunk;
+      std::size_t end = 0;
+
+      chunk.error = parse_chunk(
+        input,
+        separator,
+        lazy,
+        row,
+        [&chunk](const coordinates& coords, laskin::value&& value)
+        {
+          chunk.cells.emplace_back(coords, std::move(value));
+        },
+        row + BLOCK_ROWS,
+        &end,
+        nullptr,
+        &chunk.hashes
+      );
+      chunk.rows = row;
+      input.remove_prefix(end);
+      parsed += end;
+
+      const auto failed = chunk.error.has_value();
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        queue.push_back(std::move(chunk));
+      }
+      condition.notify_one();
+      if (failed)
+      {
+        break;
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      done = true;
+    }
+    condition.notify_one();
+  }
+};
+
+sheet::~sheet() {}
+
+void
+sheet::continue_loading(int row)
+{
+  while (loading)
+  {
+    std::deque<parsed_chunk> chunks;
+    bool done;
+
+    {
+      std::unique_lock<std::mutex> lock(loading->mutex);
+
+      if (row >= 0)
+      {
+        loading->condition.wait(lock, [this]()
+        {
+          return !loading->queue.empty() || loading->done;
+        });
+      }
+      chunks.swap(loading->queue);
+      done = loading->done;
+    }
+
+    store_loaded([this, &chunks]()
+    {
+      for (auto& chunk : chunks)
+      {
+        if (chunk.error)
+        {
+          load_error = chunk.error;
+        }
+        for (const auto& [coords, value] : chunk.cells)
+        {
+          store(coords, value, loading->lazy);
+        }
+        row_hashes.insert(
+          std::end(row_hashes),
+          std::begin(chunk.hashes),
+          std::end(chunk.hashes)
+        );
+        loaded_rows = chunk.rows;
+      }
+    });
+
+    if (done)
+    {
+      loading.reset();
+      loaded_rows = coordinates::MAX_Y;
+    }
+    if (row < 0 || loaded_rows > row)
+    {
+      break;
+    }
+  }
+}
+
+std::optional<int>
+sheet::get_load_progress() const
+{
+  if (!loading || loading->total == 0)
+  {
+    return std::nullopt;
+  }
+
+  return loading->parsed * 100 / loading->total;
+}
+
+bool
+load_filter::parse_rows(const std::string& input)
+{
+  const auto separator = input.find('-');
+  std::size_t first;
+  std::size_t last = 0;
+  std::size_t end;
+
+  if (separator == std::string::npos)
+  {
+    return false;
+  }
+  try
+  {
+    first = std::stoull(input.substr(0, separator), &end);
+    if (end != separator || first < 1)
+    {
+      return false;
+    }
+    else if (separator + 1 < input.length())
+    {
+      last = std::stoull(input.substr(separator + 1), &end);
+      if (separator + 1 + end != input.length() || last < first)
+      {
+        return false;
+      }
+    }
+  }
+  catch (const std::exception&)
+  {
+    return false;
+  }
+  first_row = first - 1;
+  if (last > 0)
+  {
+    last_row = last - 1;
+  } else {
+    last_row.reset();
+  }
+
+  return true;
+}
+
+// Appends a record into the output, terminating it with a line break if it
+// isn't already.
+static void
+append_record(std::string& output, const std::string_view& record)
+{
+  output.append(record);
+  if (!record.empty() && record.back() != '\n')
+  {
+    output.append(1, '\n');
+  }
+}
+
+// Picks a uniformly distributed random sample of records with reservoir
+// sampling, keeping them in their original order. Only the sample is kept
+// in memory, no matter how many records there are.
+struct row_sampler
+{
+  std::vector<std::pair<std::size_t, std::string>> reservoir;
+  std::mt19937_64 random;
+  std::size_t size;
+  // Number of records the sample has been picked from.
+  std::size_t count;
+  // Record which is always loaded, regardless of the sample.
+  std::string header;
+
+  explicit row_sampler(const struct load_filter& filter)
+    : random((std::random_device())())
+    // Sheets can't hold more rows than this anyway.
+    , size(
+      std::min<std::size_t>(
+        filter.sample,
+        coordinates::MAX_Y - (filter.header ? 1 : 0)
+      )
+    )
+    , count(0)
+  {
+    reservoir.reserve(size);
+  }
+
+  void
+  add(const std::string_view& record)
+  {
+    if (reservoir.size() < size)
+    {
+      reservoir.emplace_back(count, record);
+    } else {
+      const auto index = std::uniform_int_distribution<std::size_t>(
+        0,
+        count
+      )(random);
+
+      if (index < size)
+      {
+        reservoir[index] = { count, std::string(record) };
+      }
+    }
+    ++count;
+  }
+
+  // Writes the header and the sample into the output.
+  void
+  write(std::string& output)
+  {
+    output.clear();
+    append_record(output, header);
+    std::sort(std::begin(reservoir), std::end(reservoir));
+    for (const auto& entry : reservoir)
+    {
+      append_record(output, entry.second);
+    }
+  }
+};
+
+// Narrows CSV data of given file down to the rows selected by the filter.
+// Offsets of the rows are looked up from an index of the file, which is
+// built when the file is first loaded partially.
+static void
+select_rows(
+  const std::filesystem::path& path,
+  std::uintmax_t size,
+  std::filesystem::file_time_type time,
+  const struct load_filter& filter,
+  char separator,
+  std::string_view& input
+)
+{
+  row_index index;
+
+  if (!filter.has_row_range())
+  {
+    return;
+  }
+  if (!index.read(path, size, time, separator))
+  {
+    index.build(input, size, time, separator);
+    index.write(path);
+  }
+
+  // Sheets can't hold more rows than this anyway.
+  const auto last_row = std::min<std::size_t>(
+    filter.last_row.value_or(SIZE_MAX),
+    filter.first_row + coordinates::MAX_Y - 1
+  );
+  const auto begin = index.find(input, filter.first_row);
+  const auto end = csv::skip_records(
+    input,
+    begin,
+    last_row - filter.first_row + 1,
+    separator
+  );
+
+  input = input.substr(begin, end - begin);
+}
+
+// Decompresses gzip compressed CSV data block by block, and passes its
+// records to the callback until it returns false. Only a block of the data
+// is kept in memory at a time.
+template<class Callback>
+static std::optional<std::u32string>
+for_each_compressed_record(
+  const std::string_view& input,
+  char separator,
+  Callback callback
+)
+{
+  gzip::decompressor decompressor(input);
+  std::string buffer;
+  bool first = true;
+
+  while (!decompressor.finished)
+  {
+    if (const auto error = decompressor.read(buffer))
+    {
+      return error;
+    }
+
+    const auto end = decompressor.finished
+      ? buffer.length()
+      : csv::find_last_record_end(buffer, separator);
+    const std::string_view records(buffer.data(), end);
+    std::size_t pos = 0;
+
+    if (first && end > 0)
+    {
+      first = false;
+      if (end >= 3 && !records.compare(0, 3, "\xef\xbb\xbf"))
+      {
+        pos = 3;
+      }
+    }
+    while (pos < end)
+    {
+      const auto next = csv::skip_records(records, pos, 1, separator);
+
+      if (!callback(records.substr(pos, next - pos)))
+      {
+        return std::nullopt;
+      }
+      pos = next;
+    }
+    buffer.erase(0, end);
+  }
+
+  return std::nullopt;
+}
+
+// Narrows contents of a CSV file down to the rows which are loaded into the
+// sheet. Compressed files are decompressed block by block, keeping only the
+// rows selected by the filter, and no more of them than fit into a sheet.
+// Rows of a random sample are picked with given sampler. Rows tested
+// against the predicate while doing so are not tested again.
+static std::optional<std::u32string>
+prepare_input(
+  const std::filesystem::path& path,
+  std::uintmax_t size,
+  std::filesystem::file_time_type time,
+  char separator,
+  const struct load_filter& filter,
+  row_filter& selection,
+  row_sampler* sampler,
+  std::string_view& input,
+  std::string& buffer
+)
+{
+  const bool compressed = gzip::is_compressed(input);
+  std::size_t first_row = 0;
+  std::optional<std::size_t> last_row;
+  std::size_t row = 0;
+  std::size_t kept = 0;
+  const auto pick = [&](const std::string_view& record)
+  {
+    const auto current = row++;
+
+    if (current < first_row)
+    {
+      return true;
+    }
+    else if (last_row && current > *last_row)
+    {
+      return false;
+    }
+    else if (sampler && current == first_row && filter.header)
+    {
+      sampler->header.assign(record);
+
+      return true;
+    }
+    else if (selection.where && !selection.matches(record, separator))
+    {
+      return true;
+    }
+    else if (sampler)
+    {
+      sampler->add(record);
+
+      return true;
+    }
+    append_record(buffer, record);
+
+    // One row more than fits into a sheet is kept, so that the file is
+    // still reported to be too long.
+    return ++kept <= coordinates::MAX_Y;
+  };
+
+  buffer.clear();
+  if (compressed)
+  {
+    if (filter.has_row_range())
+    {
+      // Sheets can't hold more rows than this anyway.
+      first_row = filter.first_row;
+      last_row = std::min<std::size_t>(
+        filter.last_row.value_or(SIZE_MAX),
+        filter.first_row + coordinates::MAX_Y - 1
+      );
+    }
+    if (const auto error = for_each_compressed_record(input, separator, pick))
+    {
+      return error;
+    }
+  } else {
+    if (input.length() >= 3 && !input.compare(0, 3, "\xef\xbb\xbf"))
+    {
+      input.remove_prefix(3);
+    }
+    select_rows(path, size, time, filter, separator, input);
+    // Rest of a plain file is parsed straight from the mapping.
+    if (!sampler)
+    {
+      return std::nullopt;
+    }
+    for (std::size_t pos = 0; pos < input.length();)
+    {
+      const auto end = csv::skip_records(input, pos, 1, separator);
+
+      pick(input.substr(pos, end - pos));
+      pos = end;
+    }
+  }
+  if (sampler)
+  {
+    sampler->write(buffer);
+  }
+  input = buffer;
+  selection.where.reset();
+
+  return std::nullopt;
+}
+
+std::optional<std::u32string>
+sheet::follow(const std::optional<std::filesystem::path>& path)
+{
+  auto result = std::make_unique<follower>();
+  std::size_t offset = 0;
+  bool partial = false;
+
+  // A record at the end of the file without a line break might still be
+  // unfinished, so it is read again from the file once it's complete.
+  if (path)
+  {
+    csv::mapped_file file;
+
+    offset = loaded_size;
+    if (file.open(*path) && file.size >= loaded_size)
+    {
+      const auto input = file.view().substr(0, loaded_size);
+      const auto end = csv::find_last_record_end(input, separator);
+      row_filter selection;
+
+      if (end < loaded_size && !selection.compile(filter))
+      {
+        offset = end;
+        // The record is in the sheet only if it was selected into it.
+        partial = !filter.last_row && filter.sample == 0 && (
+          !selection.where ||
+          selection.matches(input.substr(end), separator)
+        );
+      }
+    }
+  }
+  if (const auto error = result->open(path, offset))
+  {
+    return error;
+  }
+  following = std::move(result);
+  followed_rows = -1;
+  followed_partial_row = partial;
+
+  return std::nullopt;
+}
+
+int
+sheet::continue_following()
+{
+  std::string input;
+  std::string_view view;
+  std::optional<std::u32string> error;
+
+  // Rows appended to a file are read only once all of it has been loaded.
+  if (!following || loading)
+  {
+    return 0;
+  }
+  if ((error = following->read(input, separator)))
+  {
+    load_error = error;
+    following.reset();
+  }
+  else if (following->is_closed())
+  {
+    following.reset();
+  }
+  if (input.empty())
+  {
+    return 0;
+  }
+  if (followed_rows < 0)
+  {
+    followed_rows = max_row;
+    if (followed_partial_row && max_row > 0)
+    {
+      --followed_rows;
+    }
+  }
+  view = input;
+  if (
+    followed_rows == 0 &&
+    view.length() >= 3 &&
+    !view.compare(0, 3, "\xef\xbb\xbf")
+  )
+  {
+    view.remove_prefix(3);
+  }
+
+  const bool lazy = setting::get_int(setting::key::lazy_types);
+  const auto first = followed_rows;
+  row_filter selection;
+
+  if ((error = selection.compile(filter)))
+  {
+    load_error = error;
+    following.reset();
 
-      if (const auto range = range::parse(name))
+    return 0;
+  }
+  // Appended rows are stored the same way as rows loaded in background.
+  store_loaded([&]()
+  {
+    if (followed_partial_row)
+    {
+      for (int x = 0; x < max_col; ++x)
       {
-        if (const auto values = range->extract(*this))
-        {
-          return *values;
-        }
+        remove({ x, followed_rows });
       }
-      else if (const auto coords = coordinates::parse(name))
+      followed_partial_row = false;
+    }
+    error = parse_chunk(
+      view,
+      separator,
+      lazy,
+      followed_rows,
+      [this, lazy](const coordinates& coords, laskin::value&& value)
       {
-        const auto cell = this->grid.find(*coords);
-
-        if (cell != std::end(this->grid) && cell->second)
-        {
-          return cell->second->evaluate(this->context);;
-        }
-      }
+        store(coords, value, lazy);
+      },
+      coordinates::MAX_Y + 1,
+      nullptr,
+      &selection
+    );
+  });
+  if (error)
+  {
+    load_error = error;
+    following.reset();
+  }
 
-      return std::nullopt;
-    },
-    false
-  ) {}
+  return followed_rows - first;
+}
 
-void
-sheet::set(const coordinates& coords, const std::u32string& input)
+std::optional<std::u32string>
+sheet::load(
+  const std::filesystem::path& path,
+  char separator,
+  bool progressive
+)
 {
-  if (peelo::number::is_valid(input))
+  csv::mapped_file file;
+  // Rows picked from the file, when they are not parsed from the mapping.
+  std::string buffer;
+  std::optional<std::u32string> error;
+
+  loading.reset();
+  loaded_rows = coordinates::MAX_Y;
+  load_error.reset();
+  following.reset();
+  if (!std::filesystem::exists(path))
   {
-    set(coords, laskin::value::parse_number(input));
+    return U"File does not exist.";
+  }
+  else if (!file.open(path))
+  {
+    return U"Unable to open file.";
   }
-  else if (laskin::is_date(input))
+
+  auto input = file.view();
+  std::error_code ec;
+
+  loaded_size = file.size;
+  loaded_time = std::filesystem::last_write_time(path, ec);
+  if (binary::is_binary(input))
   {
-    set(coords, laskin::parse_date(input));
+    row_hashes.clear();
+    sample_population.reset();
+
+    return load_binary(path, input);
   }
-  else if (laskin::is_time(input))
+
+  row_filter selection;
+  std::optional<row_sampler> sampler;
+
+  if ((error = selection.compile(filter)))
   {
-    set(coords, laskin::parse_time(input));
+    return error;
   }
-  else if (laskin::is_month(input))
+  if (filter.sample > 0)
   {
-    set(coords, laskin::parse_month(input));
+    sampler.emplace(filter);
   }
-  else if (laskin::is_weekday(input))
+  if (
+    (error = prepare_input(
+      path,
+      loaded_size,
+      loaded_time,
+      separator,
+      filter,
+      selection,
+      sampler ? &*sampler : nullptr,
+      input,
+      buffer
+    ))
+  )
   {
-    set(coords, laskin::parse_weekday(input));
+    return error;
   }
-  else if (!input.compare(U"true"))
+  else if (input.data() == buffer.data())
   {
-    set(coords, true);
+    file.close();
   }
-  else if (!input.compare(U"false"))
+  if (sampler)
   {
-    set(coords, false);
+    sample_population = sampler->count;
+    sample_size = sampler->reservoir.size();
   } else {
-    set(coords, laskin::value(input));
+    sample_population.reset();
   }
-}
 
-void
-sheet::erase(const coordinates& coords)
-{
-  const auto it = grid.find(coords);
+  // Rows of the sheet don't match rows of the file when only some of them
+  // are selected, so they are hashed only when all of them are loaded.
+  const bool selective = (
+    !filter.columns.empty() ||
+    !filter.where.empty() ||
+    filter.sample > 0
+  );
 
-  if (it != std::end(grid))
-  {
-    grid.erase(it);
-  }
-}
+  row_hashes.clear();
 
-bool
-sheet::join(const coordinates& c1, const coordinates& c2)
-{
-  if (c1.is_valid() && c2.is_valid())
+  // Unless disabled, types of the values are decided only once the cells are
+  // actually read.
+  const bool lazy = setting::get_int(setting::key::lazy_types);
+  // Small files are loaded quickly enough in one go. Selected rows are
+  // parsed on this thread, as the predicate can only be evaluated here.
+  const bool in_background = (
+    progressive &&
+    !selective &&
+    input.length() >= PROGRESSIVE_LOAD_THRESHOLD
+  );
+  const auto chunks = in_background || selective
+    ? std::vector<std::string_view>{ input }
+    : csv::split(
+      input,
+      std::min<std::size_t>(
+        std::thread::hardware_concurrency(),
+        input.length() / PARALLEL_LOAD_THRESHOLD
+      ),
+      separator
+    );
+
+  begin_batch();
+  clear();
+  recovery.reset();
+  recovery.enabled = false;
+  binary_path.reset();
+  if (chunks.size() > 1)
   {
-    const auto cell1 = get(c1);
-    const auto cell2 = get(c2);
+    std::vector<parsed_chunk> results(chunks.size());
+    std::vector<std::thread> threads;
+    int offset = 0;
 
-    if (cell1 && cell2)
+    for (std::size_t i = 0; i < chunks.size(); ++i)
     {
-      const auto value1 = cell1->evaluate(context);
-      const auto value2 = cell2->evaluate(context);
-      laskin::value result;
+      threads.emplace_back([&chunks, &results, separator, lazy, i]()
+      {
+        auto& result = results[i];
 
-      try
+        result.error = parse_chunk(
+          chunks[i],
+          separator,
+          lazy,
+          result.rows,
+          [&result](const coordinates& coords, laskin::value&& value)
+          {
+            result.cells.emplace_back(coords, std::move(value));
+          },
+          coordinates::MAX_Y + 1,
+          nullptr,
+          nullptr,
+          &result.hashes
+        );
+      });
+    }
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+
+    // Merge the chunks in order, offsetting their rows.
+    for (auto& result : results)
+    {
+      if (result.error)
       {
-        result = value1 + value2;
+        error = result.error;
+        break;
       }
-      catch (const laskin::error& e)
+      else if (offset + result.rows > coordinates::MAX_Y)
       {
-        return false;
+        error = U"Spreadsheet too long.";
+        break;
       }
-      set(c1, result);
-      erase(c2);
+      for (const auto& [coords, value] : result.cells)
+      {
+        store({ coords.x, coords.y + offset }, value, lazy);
+      }
+      row_hashes.insert(
+        std::end(row_hashes),
+        std::begin(result.hashes),
+        std::end(result.hashes)
+      );
+      offset += result.rows;
+      result.cells = {};
+    }
+  } else {
+    const auto row_limit = in_background
+      ? INITIAL_ROWS
+      : coordinates::MAX_Y + 1;
+    std::size_t end = 0;
+    int row = 0;
 
-      return true;
+    error = parse_chunk(
+      input,
+      separator,
+      lazy,
+      row,
+      [this, lazy](const coordinates& coords, laskin::value&& value)
+      {
+        store(coords, value, lazy);
+      },
+      row_limit,
+      &end,
+      &selection,
+      selective ? nullptr : &row_hashes
+    );
+
+    // Continue with rest of the input on a background thread, which takes
+    // over the mapping or the rows picked from the file. The input may be
+    // only a range of rows of the file.
+    if (!error && end < input.length())
+    {
+      const auto offset = buffer.empty()
+        ? input.data() - file.data
+        : input.data() - buffer.data();
+
+      loading = std::make_unique<background_load>();
+      loading->total = input.length();
+      loading->parsed = end;
+      loading->lazy = lazy;
+      loading->done = false;
+      loading->cancelled = false;
+      std::swap(loading->file.data, file.data);
+      std::swap(loading->file.size, file.size);
+      loading->buffer = std::move(buffer);
+      loaded_rows = row;
+      loading->thread = std::thread(
+        &background_load::run,
+        loading.get(),
+        (
+          loading->buffer.empty()
+            ? loading->file.view()
+            : std::string_view(loading->buffer)
+        ).substr(offset + end, input.length() - end),
+        separator,
+        row
+      );
     }
   }
+  commit();
+  recovery.enabled = true;
+  if (error)
+  {
+    return error;
+  }
+  // Contents of the file replace whatever an enclosing batch did before.
+  batch_changes = 0;
+  modified = false;
 
-  return false;
+  return std::nullopt;
 }
 
 std::optional<std::u32string>
-sheet::load(const std::filesystem::path& path, char separator)
+sheet::load_binary(
+  const std::filesystem::path& path,
+  const std::string_view& input
+)
 {
-  using peelo::unicode::encoding::utf8::decode;
+  binary::contents contents;
 
-  if (!std::filesystem::exists(path))
+  if (const auto error = binary::read(input, contents))
   {
-    return U"File does not exist.";
+    return error;
   }
 
-  rapidcsv::Document doc(
-    path.string(),
-    rapidcsv::LabelParams(-1, -1),
-    rapidcsv::SeparatorParams(separator)
-  );
-  const auto size = doc.GetRowCount();
+  const bool lazy = setting::get_int(setting::key::lazy_types);
+  const auto put = [this, lazy](
+    const coordinates& coords,
+    const laskin::value& value,
+    bool raw
+  )
+  {
+    if (raw && !lazy)
+    {
+      store(coords, parse_value(value.as_string()));
+    } else {
+      store(coords, value, raw);
+    }
+  };
 
-  if (size > coordinates::MAX_Y)
+  begin_batch();
+  clear();
+  recovery.reset();
+  recovery.enabled = false;
+  for (auto& record : contents.records)
   {
-    return U"Spreadsheet too long.";
+    put(record.coordinates, record.value, record.raw);
+    if (record.result)
+    {
+      results.emplace(record.coordinates, std::move(*record.result));
+    }
   }
-  grid.clear();
-  for (std::size_t i = 0; i < size; ++i)
+  for (const auto& change : contents.changes)
   {
-    const auto row = doc.GetRow<std::string>(i);
-
-    if (row.size() > coordinates::MAX_X)
+    if (!change.coordinates.is_valid())
     {
-      return U"Spreadsheet too wide.";
+      continue;
     }
-    for (std::size_t j = 0; j < row.size(); ++j)
+    else if (change.value)
     {
-      set(
-        coordinates{ static_cast<int>(j), static_cast<int>(i) },
-        decode(row[j])
-      );
+      put(change.coordinates, *change.value, change.raw);
+    } else {
+      remove(change.coordinates);
     }
   }
+  commit();
+  recovery.enabled = true;
+  batch_changes = 0;
   modified = false;
+  // Results were evaluated before the changes were made.
+  if (!contents.changes.empty())
+  {
+    results.clear();
+  }
+  results_generation = get_generation();
+  binary_path = path;
+  binary_size = input.length() - contents.changes_size;
+  binary_changes_size = contents.changes_size;
 
   return std::nullopt;
 }
 
-static std::string
-escape(const std::string& input)
+bool
+sheet::is_changed_on_disk() const
 {
-  const auto length = input.length();
-  std::string result(1, '"');
+  std::error_code ec;
 
-  result.reserve(length + 2);
-  for (std::size_t i = 0; i < length; ++i)
+  if (!filename)
   {
-    const auto c = input[i];
+    return false;
+  }
 
-    if (c == '"')
-    {
-      result.append(2, '"');
-    } else {
-      result.append(1, c);
-    }
+  const auto size = std::filesystem::file_size(*filename, ec);
+
+  if (ec)
+  {
+    return false;
   }
 
-  return result.append(1, '"');
+  const auto time = std::filesystem::last_write_time(*filename, ec);
+
+  return !ec && (size != loaded_size || time != loaded_time);
 }
 
-bool
-sheet::save(const std::filesystem::path& path, char separator)
+std::optional<std::u32string>
+sheet::reload(int& changed_rows)
 {
-  using peelo::unicode::encoding::utf8::encode;
+  csv::mapped_file file;
+  std::string buffer;
+  std::vector<std::pair<coordinates, laskin::value>> cells;
+  row_filter selection;
+  std::optional<std::u32string> error;
+  std::error_code ec;
 
-  std::ofstream out(path);
-  int max_row = 0;
-  int max_col = 0;
+  changed_rows = 0;
+  if (!filename || !file.open(*filename))
+  {
+    return U"Unable to open file.";
+  }
 
-  if (!out.is_open())
+  auto input = file.view();
+
+  // Binary files are quick to load, so they are simply loaded again, as are
+  // sheets whose rows don't match rows of the file.
+  if (
+    binary::is_binary(input) ||
+    !filter.columns.empty() ||
+    !filter.where.empty() ||
+    filter.sample > 0
+  )
   {
-    return false;
+    file.close();
+
+    return load(*filename, separator);
+  }
+  loaded_size = file.size;
+  loaded_time = std::filesystem::last_write_time(*filename, ec);
+  if (
+    (error = prepare_input(
+      *filename,
+      loaded_size,
+      loaded_time,
+      separator,
+      filter,
+      selection,
+      nullptr,
+      input,
+      buffer
+    ))
+  )
+  {
+    return error;
+  }
+
+  // Records are hashed as they are read, and only fields of the ones which
+  // differ from the rows loaded before are decoded and classified.
+  const bool lazy = setting::get_int(setting::key::lazy_types);
+  std::vector<std::uint64_t> hashes;
+  std::vector<std::string> fields;
+  std::size_t field_count = 0;
+  std::string scratch;
+  std::u32string field;
+  auto hash = csv::EMPTY_RECORD_HASH;
+  const auto is_changed = [this, &hashes](int y)
+  {
+    return (
+      y >= static_cast<int>(hashes.size()) ||
+      y >= static_cast<int>(row_hashes.size()) ||
+      hashes[y] != row_hashes[y]
+    );
+  };
+
+  csv::parse(
+    input,
+    separator,
+    scratch,
+    [&](std::size_t column, const std::string_view& value)
+    {
+      if (hashes.size() >= coordinates::MAX_Y)
+      {
+        error = U"Spreadsheet too long.";
+
+        return false;
+      }
+      else if (column >= coordinates::MAX_X)
+      {
+        error = U"Spreadsheet too wide.";
+
+        return false;
+      }
+      else if (!value.empty())
+      {
+        hash = csv::hash_field(hash, column, value);
+      }
+      if (column >= fields.size())
+      {
+        fields.resize(column + 1);
+      }
+      fields[column].assign(value);
+      field_count = column + 1;
+
+      return true;
+    },
+    [&]()
+    {
+      const int y = hashes.size();
+
+      hashes.push_back(hash);
+      hash = csv::EMPTY_RECORD_HASH;
+      for (std::size_t x = 0; is_changed(y) && x < field_count; ++x)
+      {
+        if (!fields[x].empty())
+        {
+          utils::decode_utf8(fields[x], field);
+          cells.emplace_back(
+            coordinates{ static_cast<int>(x), y },
+            lazy ? laskin::value(field) : parse_value(field)
+          );
+        }
+      }
+      field_count = 0;
+
+      return true;
+    }
+  );
+  if (error)
+  {
+    return error;
   }
 
-  // Find dimensions of used grid.
-  for (const auto& pair : grid)
+  // Changes made by other programs are stored the same way as rows loaded
+  // in background, without marking the sheet as modified.
+  const auto rows = std::max<int>(max_row, hashes.size());
+  auto it = std::begin(cells);
+
+  store_loaded([&]()
   {
-    if (pair.second)
+    for (int y = 0; y < rows; ++y)
     {
-      const auto& cell = *pair.second;
+      if (!is_changed(y))
+      {
+        continue;
+      }
+      ++changed_rows;
+      for (int x = 0; x < max_col; ++x)
+      {
+        remove({ x, y });
+      }
+      for (; it != std::end(cells) && it->first.y == y; ++it)
+      {
+        store(it->first, it->second, lazy);
+      }
+    }
+  });
+  row_hashes = std::move(hashes);
+
+  return std::nullopt;
+}
+
+// Size of output buffered before it's written into the file.
+static constexpr std::size_t SAVE_BUFFER_SIZE = 1 << 20;
+
+// Sheets with more cells than this are formatted in parallel.
+static constexpr std::size_t PARALLEL_SAVE_THRESHOLD = 4096;
 
-      max_col = std::max(max_col, cell.coordinates.x + 1);
-      max_row = std::max(max_row, cell.coordinates.y + 1);
+// Combines a field just written into the output into hash of its record.
+// Fields which needed quoting are unquoted for hashing. Others can't begin
+// with a quote, so they are hashed as they are.
+static std::uint64_t
+hash_written_field(
+  std::uint64_t hash,
+  int column,
+  const std::string_view& written,
+  std::string& scratch
+)
+{
+  if (written.empty())
+  {
+    return hash;
+  }
+  else if (written[0] != '"')
+  {
+    return csv::hash_field(hash, column, written);
+  }
+  scratch.clear();
+  for (std::size_t i = 1; i + 1 < written.length(); ++i)
+  {
+    scratch.append(1, written[i]);
+    if (written[i] == '"')
+    {
+      ++i;
     }
   }
 
-  // Write CSV data.
-  for (int y = 0; y < max_row; ++y)
+  return csv::hash_field(hash, column, scratch);
+}
+
+static void
+format_rows(
+  const struct snapshot& snapshot,
+  int first,
+  int last,
+  char separator,
+  std::string& output,
+  std::atomic<int>* progress,
+  std::vector<std::uint64_t>* hashes
+)
+{
+  std::string scratch;
+
+  for (int y = first; y < last; ++y)
   {
-    for (int x = 0; x < max_col; ++x)
+    auto hash = csv::EMPTY_RECORD_HASH;
+
+    for (int x = 0; x < snapshot.max_col; ++x)
     {
       if (x > 0)
       {
-        out << separator;
+        output.append(1, separator);
       }
-      if (const auto cell = get({ x, y }))
+      if (const auto cell = snapshot.get({ x, y }))
       {
-        const auto source = encode(cell->get_source());
+        const auto start = output.length();
 
-        if (
-          source.find(separator) != std::string::npos ||
-          source.find('"') != std::string::npos ||
-          source.find('\n') != std::string::npos ||
-          source.find('\r') != std::string::npos
-        )
+        // Strings are their own source, so they can be written without
+        // making a copy of them.
+        if (cell->value.is(laskin::value::type::string))
         {
-          out << escape(source);
+          csv::write_field(output, cell->value.as_string(), separator);
         } else {
-          out << source;
+          csv::write_field(output, cell->get_source(), separator);
+        }
+        if (hashes)
+        {
+          hash = hash_written_field(
+            hash,
+            x,
+            std::string_view(output).substr(start),
+            scratch
+          );
         }
       }
     }
-    out << '\n';
+    output.append(1, '\n');
+    if (hashes)
+    {
+      hashes->push_back(hash);
+    }
+    if (progress)
+    {
+      progress->fetch_add(1, std::memory_order_relaxed);
+    }
   }
+}
 
-  modified = false;
+bool
+sheet::save(const std::filesystem::path& path, char separator)
+{
+  const auto snapshot = take_snapshot(path);
+  std::vector<std::uint64_t> hashes;
 
-  return true;
+  if (save(snapshot, path, separator, nullptr, &hashes))
+  {
+    saved(snapshot, path, std::move(hashes));
+
+    return true;
+  }
+
+  return false;
+}
+
+bool
+sheet::save(
+  const struct snapshot& snapshot,
+  const std::filesystem::path& path,
+  char separator,
+  std::atomic<int>* progress,
+  std::vector<std::uint64_t>* hashes
+)
+{
+  csv::output_file file;
+
+  if (snapshot.incremental)
+  {
+    return binary::append(path, snapshot.changes);
+  }
+  else if (binary::is_binary_path(path))
+  {
+    return (
+      file.open(path) &&
+      file.write(binary::write(snapshot, progress)) &&
+      file.commit()
+    );
+  }
+
+  const auto count = std::min<std::size_t>(
+    std::min<std::size_t>(
+      std::thread::hardware_concurrency(),
+      snapshot.grid.size() / PARALLEL_SAVE_THRESHOLD
+    ),
+    snapshot.max_row
+  );
+  std::optional<gzip::compressor> compressor;
+  const auto write = [&file, &compressor](const std::string_view& data)
+  {
+    return compressor ? compressor->write(file, data) : file.write(data);
+  };
+
+  if (!file.open(path))
+  {
+    return false;
+  }
+  else if (gzip::is_compressed_path(path))
+  {
+    compressor.emplace(snapshot.compression_level);
+  }
+
+  if (count > 1)
+  {
+    // Format blocks of rows into separate buffers on worker threads, then
+    // write them out in order. The snapshot is never modified, so it can be
+    // read from all of them at once.
+    std::vector<std::string> buffers(count);
+    std::vector<std::vector<std::uint64_t>> block_hashes(count);
+    std::vector<std::thread> threads;
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      threads.emplace_back(
+        [&snapshot, &buffers, &block_hashes, separator, progress, hashes,
+         count, i]()
+        {
+          format_rows(
+            snapshot,
+            snapshot.max_row * i / count,
+            snapshot.max_row * (i + 1) / count,
+            separator,
+            buffers[i],
+            progress,
+            hashes ? &block_hashes[i] : nullptr
+          );
+        }
+      );
+    }
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      if (!write(buffers[i]))
+      {
+        return false;
+      }
+      else if (hashes)
+      {
+        hashes->insert(
+          std::end(*hashes),
+          std::begin(block_hashes[i]),
+          std::end(block_hashes[i])
+        );
+      }
+    }
+  } else {
+    std::string buffer;
+
+    buffer.reserve(SAVE_BUFFER_SIZE * 2);
+    for (int y = 0; y < snapshot.max_row; ++y)
+    {
+      format_rows(snapshot, y, y + 1, separator, buffer, progress, hashes);
+      if (buffer.length() >= SAVE_BUFFER_SIZE)
+      {
+        if (!write(buffer))
+        {
+          return false;
+        }
+        buffer.clear();
+      }
+    }
+    if (!write(buffer))
+    {
+      return false;
+    }
+  }
+
+  if (compressor && !compressor->finish(file))
+  {
+    return false;
+  }
+
+  return file.commit();
 }
 
 bool
@@ -280,22 +2291,8 @@ sheet::find_literal_substring(
     return false;
   }
 
-  int max_col = 0;
-  int max_row = 0;
-
-  for (const auto& pair : grid)
-  {
-    if (pair.second)
-    {
-      const auto& cell = *pair.second;
-
-      max_col = std::max(max_col, cell.coordinates.x + 1);
-      max_row = std::max(max_row, cell.coordinates.y + 1);
-    }
-  }
-
-  max_col = std::max(max_col, cursor_pos.x + 1);
-  max_row = std::max(max_row, cursor_pos.y + 1);
+  const int max_col = std::max(this->max_col, cursor_pos.x + 1);
+  const int max_row = std::max(this->max_row, cursor_pos.y + 1);
 
   const int total = max_col * max_row;
 
@@ -306,7 +2303,7 @@ sheet::find_literal_substring(
 
   auto cell_text = [this](int x, int y) -> std::u32string
   {
-    if (const auto c = get({ x, y }))
+    if (const auto c = peek({ x, y }))
     {
       return c->get_source();
     }
@@ -25,64 +25,376 @@
  */
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <filesystem>
+#include <string>
+#include <vector>
 
-#include "./cell.hpp"
+#include "./grid.hpp"
+#include "./journal.hpp"
+#include "./recovery.hpp"
+
+struct background_load;
+struct follower;
+struct workbook;
+
+// Part of a CSV file to load into a sheet, when all of it isn't wanted.
+struct load_filter
+{
+  // Range of rows of the file to load, counting from zero.
+  std::size_t first_row = 0;
+  std::optional<std::size_t> last_row;
+  // Columns of the file to load, placed side by side into the sheet in this
+  // order. All of them are loaded when empty.
+  std::vector<std::size_t> columns;
+  // Laskin expression which rows of the file have to satisfy in order to be
+  // loaded. Fields of the row are referred to by letters of their columns.
+  std::u32string where;
+  // Number of rows to pick randomly from the file, or zero to load all of
+  // them, and whether the first row is a header which is always loaded.
+  std::size_t sample = 0;
+  bool header = false;
+
+  inline bool
+  has_row_range() const
+  {
+    return first_row > 0 || last_row;
+  }
+
+  inline bool
+  is_partial() const
+  {
+    return (
+      has_row_range() ||
+      !columns.empty() ||
+      !where.empty() ||
+      sample > 0
+    );
+  }
+
+  // Parses range of rows such as `1000-1999` or `1000-`, numbered from one.
+  bool
+  parse_rows(const std::string& input);
+
+  // Parses list of columns such as `A,C,AF`.
+  bool
+  parse_columns(const std::string& input);
+};
+
+// Point-in-time copy of a sheet's contents, which shares storage with the
+// sheet and can be read from other threads while the sheet is modified.
+struct snapshot
+{
+  struct grid grid;
+  int max_row;
+  int max_col;
+  unsigned long version;
+  // Evaluated values of formulas, filled in only when they are needed.
+  std::unordered_map<coordinates, laskin::value> results;
+  // Changes made since the sheet was last saved, encoded with
+  // binary::put_change().
+  std::string changes;
+  // Whether the changes should be appended to an existing binary file
+  // instead of writing the whole sheet.
+  bool incremental;
+  // Level used when the snapshot is saved into a compressed file.
+  int compression_level;
+
+  inline const cell*
+  get(const coordinates& coords) const
+  {
+    return grid.find(coords);
+  }
+};
 
 struct sheet
 {
-  using container_type = std::unordered_map<coordinates, std::optional<cell>>;
+  using error_container_type = std::unordered_map<coordinates, std::string>;
 
   static constexpr char DEFAULT_SEPARATOR = ',';
 
   std::optional<std::filesystem::path> filename;
+  struct workbook* workbook;
   bool modified;
   char separator;
-  container_type grid;
+  struct grid grid;
+  error_container_type errors;
   laskin::context context;
+  // Number of occupied cells on each row and column, used for maintaining
+  // dimensions of used grid without having to scan it.
+  std::array<int, coordinates::MAX_Y> row_counts;
+  std::array<int, coordinates::MAX_X> column_counts;
+  int max_row;
+  int max_col;
+  struct journal journal;
+  // Incremented on every change to the grid.
+  unsigned long version;
+  // Nesting level of open batches and number of changes made in them.
+  int batch_depth;
+  std::size_t batch_changes;
+  // Results of formulas loaded from a file, used until the workbook is
+  // changed in any way.
+  std::unordered_map<coordinates, laskin::value> results;
+  unsigned long results_generation;
+  struct recovery_log recovery;
+  // Binary file the sheet was last loaded from or saved into, along with
+  // sizes of the whole sheet and the changes appended to it since.
+  std::optional<std::filesystem::path> binary_path;
+  std::size_t binary_size;
+  std::size_t binary_changes_size;
+  // Rest of the file when it's being loaded on a background thread, number
+  // of rows loaded so far and error the loading ended with, if any.
+  std::unique_ptr<background_load> loading;
+  int loaded_rows;
+  std::optional<std::u32string> load_error;
+  // Size, modification time and hashes of the rows of the file the sheet
+  // was last loaded from or saved into, used for detecting and applying
+  // changes made to it by other programs.
+  std::size_t loaded_size;
+  std::filesystem::file_time_type loaded_time;
+  std::vector<std::uint64_t> row_hashes;
+  // File or pipe followed for appended rows, and the row where the next one
+  // goes, or -1 if they go after the last row of the sheet. If the last row
+  // was loaded from a record the writer hadn't finished, it is replaced once
+  // the record is complete.
+  std::unique_ptr<follower> following;
+  int followed_rows;
+  bool followed_partial_row;
+  struct load_filter filter;
+  // Number of rows in a random sample loaded into the sheet, and number of
+  // rows it was picked from.
+  std::size_t sample_size;
+  std::optional<std::size_t> sample_population;
 
   explicit sheet();
+  ~sheet();
 
-  inline std::optional<cell>
-  get(const coordinates& coords) const
+  inline const cell*
+  get(const coordinates& coords)
+  {
+    if (coords.y >= loaded_rows)
+    {
+      continue_loading(coords.y);
+    }
+
+    const auto cell = grid.find(coords);
+
+    return cell && cell->raw ? classify(coords) : cell;
+  }
+
+  // Like get(), but leaves the type of a loaded cell undecided, for callers
+  // which are only interested in the source text.
+  inline const cell*
+  peek(const coordinates& coords) const
   {
-    const auto it = grid.find(coords);
+    return grid.find(coords);
+  }
+
+  const cell*
+  classify(const coordinates& coords);
+
+  // Takes a snapshot for saving the sheet into given file, or just a copy
+  // of the cells if no file is given.
+  struct snapshot
+  take_snapshot(
+    const std::optional<std::filesystem::path>& destination = std::nullopt
+  );
+
+  // Called once given snapshot has been saved into given file, with hashes
+  // of the rows written into it.
+  void
+  saved(
+    const struct snapshot& snapshot,
+    const std::filesystem::path& path,
+    std::vector<std::uint64_t>&& hashes
+  );
+
+  // Applies changes left behind in the recovery log by a previous session.
+  // Returns the number of changes recovered.
+  std::size_t
+  recover();
 
-    return it != std::end(grid) && it->second ? it->second : std::nullopt;
+  // Returns a number which changes whenever this sheet or any other sheet
+  // of the workbook changes.
+  unsigned long
+  get_generation() const;
+
+  inline const std::string*
+  get_error(const coordinates& coords) const
+  {
+    const auto it = errors.find(coords);
+
+    return it != std::end(errors) ? &it->second : nullptr;
   }
 
+  laskin::value
+  evaluate(const coordinates& coords, const cell& cell);
+
+  std::optional<laskin::value>
+  lookup(const std::u32string& name);
+
+  static laskin::value
+  parse_value(const std::u32string& input);
+
+  void
+  set(const coordinates& coords, const laskin::value& value);
+
   inline void
-  set(const coordinates& coords, const laskin::value& value)
+  set(const coordinates& coords, const std::u32string& input)
   {
-    grid[coords] = { coords, value };
-    modified = true;
+    set(coords, parse_value(input));
   }
 
   void
-  set(const coordinates& coords, const std::u32string& input);
+  erase(const coordinates& coords);
 
   void
-  erase(const coordinates& coords);
+  store(
+    const coordinates& coords,
+    const laskin::value& value,
+    bool raw = false
+  );
+
+  std::optional<laskin::value>
+  remove(const coordinates& coords);
+
+  void
+  clear();
+
+  void
+  begin_batch();
+
+  void
+  commit();
+
+  void
+  touch();
+
+  void
+  shrink_extent();
+
+  // Runs given callback, which stores contents of the file into the sheet
+  // with store() and remove(). They are not changes made by the user, so
+  // the sheet isn't marked as modified and they aren't recorded anywhere.
+  template<class Callback>
+  inline void
+  store_loaded(Callback callback)
+  {
+    const auto changes = batch_changes;
+
+    recovery.enabled = false;
+    ++batch_depth;
+    callback();
+    --batch_depth;
+    batch_changes = changes;
+    recovery.enabled = true;
+    ++version;
+    shrink_extent();
+  }
+
+  std::optional<coordinates>
+  undo();
+
+  std::optional<coordinates>
+  redo();
 
   bool
   join(const coordinates& c1, const coordinates& c2);
 
+  // Loads given file into the sheet. Large CSV files can be loaded
+  // progressively, in which case only the first rows are loaded before
+  // returning and the rest are parsed in background.
   std::optional<std::u32string>
-  load(const std::filesystem::path& path, char separator = DEFAULT_SEPARATOR);
+  load(
+    const std::filesystem::path& path,
+    char separator = DEFAULT_SEPARATOR,
+    bool progressive = false
+  );
+
+  // Stores rows parsed in background so far. If a row is given, waits until
+  // that row has been loaded.
+  void
+  continue_loading(int row = -1);
+
+  inline void
+  finish_loading()
+  {
+    continue_loading(coordinates::MAX_Y);
+  }
+
+  inline bool
+  is_loading() const
+  {
+    return loading != nullptr;
+  }
+
+  // Returns percentage of the file loaded in background so far.
+  std::optional<int>
+  get_load_progress() const;
+
+  // Starts following the file the sheet was loaded from for rows appended
+  // to it, or standard input if no file is given.
+  std::optional<std::u32string>
+  follow(const std::optional<std::filesystem::path>& path);
+
+  // Stores rows appended to the followed file since last call. Returns the
+  // number of rows added.
+  int
+  continue_following();
+
+  inline bool
+  is_following() const
+  {
+    return following != nullptr;
+  }
+
+  // Returns the file whose recovery log the sheet uses. Sheets which contain
+  // only part of their file don't have one.
+  inline std::optional<std::filesystem::path>
+  get_recovery_filename() const
+  {
+    return filter.is_partial() ? std::nullopt : filename;
+  }
+
+  // Tests whether the file of the sheet has been changed since the sheet
+  // was loaded from or saved into it.
+  bool
+  is_changed_on_disk() const;
+
+  // Loads rows of the file which have been changed by another program since
+  // the sheet was loaded from or saved into it.
+  std::optional<std::u32string>
+  reload(int& changed_rows);
+
+  std::optional<std::u32string>
+  load_binary(
+    const std::filesystem::path& path,
+    const std::string_view& input
+  );
 
   bool
   save(const std::filesystem::path& path, char separator = DEFAULT_SEPARATOR);
 
+  // Writes given snapshot into a file, counting the rows written so far in
+  // `progress` if given. Hashes of the rows written into a CSV file, as
+  // csv::hash_records() would return them, are stored into `hashes` if
+  // given. Safe to call from any thread.
+  static bool
+  save(
+    const struct snapshot& snapshot,
+    const std::filesystem::path& path,
+    char separator = DEFAULT_SEPARATOR,
+    std::atomic<int>* progress = nullptr,
+    std::vector<std::uint64_t>* hashes = nullptr
+  );
+
   inline void
   reset_errors()
   {
-    for (const auto& cell : grid)
-    {
-      if (cell.second && cell.second->error)
-      {
-        cell.second->error.reset();
-      }
-    }
+    errors.clear();
   }
 
   void
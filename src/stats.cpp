@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <cstdio>
+
+#include <peelo/unicode/encoding/utf8.hpp>
+
+#include "./registry.hpp"
+#include "./stats.hpp"
+#include "./workbook.hpp"
+
+namespace stats
+{
+  static const std::vector<
+    std::pair<laskin::value::type, const char*>
+  > type_names =
+  {
+    { laskin::value::type::boolean, "boolean" },
+    { laskin::value::type::date, "date" },
+    { laskin::value::type::month, "month" },
+    { laskin::value::type::number, "number" },
+    { laskin::value::type::string, "string" },
+    { laskin::value::type::time, "time" },
+    { laskin::value::type::weekday, "weekday" },
+  };
+
+  static std::u32string
+  format_bytes(std::size_t bytes)
+  {
+    using peelo::unicode::encoding::utf8::decode;
+
+    static const char* units[] = { "B", "KiB", "MiB", "GiB" };
+    char buffer[64];
+    double amount = bytes;
+    std::size_t unit = 0;
+
+    while (amount >= 1024.0 && unit < 3)
+    {
+      amount /= 1024.0;
+      ++unit;
+    }
+    if (unit == 0)
+    {
+      std::snprintf(buffer, sizeof(buffer), "%zu B", bytes);
+    } else {
+      std::snprintf(buffer, sizeof(buffer), "%.1f %s", amount, units[unit]);
+    }
+
+    return decode(buffer);
+  }
+
+  static std::u32string
+  format_line(const char* label, const std::u32string& value)
+  {
+    using peelo::unicode::encoding::utf8::decode;
+
+    char buffer[64];
+
+    std::snprintf(buffer, sizeof(buffer), "%-24s", label);
+
+    return decode(buffer) + value;
+  }
+
+  static std::u32string
+  format_line(const char* label, std::size_t value)
+  {
+    using peelo::unicode::encoding::utf8::decode;
+
+    return format_line(label, decode(std::to_string(value)));
+  }
+
+  std::size_t
+  get_value_size(const laskin::value& value)
+  {
+    std::size_t result = sizeof(laskin::value);
+
+    if (value.is(laskin::value::type::string))
+    {
+      result += value.as_string().capacity() * sizeof(char32_t);
+    }
+
+    return result;
+  }
+
+  std::vector<std::u32string>
+  memory(const struct sheet& sheet)
+  {
+    using peelo::unicode::encoding::utf8::decode;
+
+    const auto& grid = sheet.grid;
+    std::vector<std::size_t> type_counts(type_names.size() + 1);
+    std::size_t cells = 0;
+    std::size_t raw_cells = 0;
+    std::size_t string_bytes = 0;
+    std::size_t error_bytes = 0;
+    std::size_t result_bytes = 0;
+    std::size_t tiles = 0;
+    std::size_t shared_tiles = 0;
+    std::size_t buckets = 0;
+    std::vector<std::u32string> result;
+    char buffer[64];
+
+    grid.for_each([&](const coordinates&, const struct cell& cell)
+    {
+      const auto& value = cell.value;
+      std::size_t i;
+
+      ++cells;
+      if (cell.raw)
+      {
+        ++raw_cells;
+      } else {
+        for (i = 0; i < type_names.size(); ++i)
+        {
+          if (value.is(type_names[i].first))
+          {
+            break;
+          }
+        }
+        ++type_counts[i];
+      }
+      if (value.is(laskin::value::type::string))
+      {
+        string_bytes += value.as_string().capacity() * sizeof(char32_t);
+      }
+    });
+    for (const auto& tile : grid.tiles)
+    {
+      if (tile)
+      {
+        ++tiles;
+        buckets += tile->bucket_count();
+        if (tile.use_count() > 1)
+        {
+          ++shared_tiles;
+        }
+      }
+    }
+    for (const auto& pair : sheet.errors)
+    {
+      error_bytes += sizeof(void*) + sizeof(std::size_t) + sizeof(pair);
+      error_bytes += pair.second.capacity();
+    }
+    error_bytes += sheet.errors.bucket_count() * sizeof(void*);
+    for (const auto& pair : sheet.results)
+    {
+      result_bytes += sizeof(void*) + sizeof(std::size_t) + sizeof(pair.first);
+      result_bytes += get_value_size(pair.second);
+    }
+    result_bytes += sheet.results.bucket_count() * sizeof(void*);
+
+    const auto recovery_bytes = sheet.recovery.changes.capacity();
+    const auto hash_bytes = (
+      sheet.row_hashes.capacity() * sizeof(std::uint64_t)
+    );
+
+    // Nodes of std::unordered_map hold the next pointer and cached hash code
+    // in addition to the key/value pair itself.
+    const auto node_bytes = grid.size() * (
+      sizeof(grid::tile::value_type) +
+      sizeof(void*) +
+      sizeof(std::size_t)
+    );
+    const auto bucket_bytes = (
+      buckets * sizeof(void*) +
+      tiles * (sizeof(grid::tile) + 2 * sizeof(void*))
+    );
+    const auto registers = registry::get_usage();
+
+    if (sheet.workbook)
+    {
+      std::size_t loaded = 0;
+
+      for (const auto& entry : sheet.workbook->entries)
+      {
+        if (entry.loaded)
+        {
+          ++loaded;
+        }
+      }
+      result.push_back(
+        format_line("Sheets:", sheet.workbook->entries.size()) +
+        U" (" +
+        decode(std::to_string(loaded)) +
+        U" loaded, statistics below are for the current one)"
+      );
+    }
+    result.push_back(format_line("Occupied cells:", cells));
+    for (std::size_t i = 0; i < type_names.size(); ++i)
+    {
+      if (type_counts[i] > 0)
+      {
+        std::snprintf(buffer, sizeof(buffer), "  %s:", type_names[i].second);
+        result.push_back(format_line(buffer, type_counts[i]));
+      }
+    }
+    if (type_counts.back() > 0)
+    {
+      result.push_back(format_line("  other:", type_counts.back()));
+    }
+    if (raw_cells > 0)
+    {
+      result.push_back(format_line("  not yet classified:", raw_cells));
+    }
+    if (sheet.max_row > 0 && sheet.max_col > 0)
+    {
+      const coordinates last = { sheet.max_col - 1, sheet.max_row - 1 };
+
+      result.push_back(format_line("Used range:", U"A1:" + last.to_string()));
+    }
+    result.push_back(
+      format_line("Grid tiles:", tiles) +
+      U" (" +
+      decode(std::to_string(shared_tiles)) +
+      U" shared with snapshots)"
+    );
+    result.push_back(format_line("Grid nodes:", format_bytes(node_bytes)));
+    result.push_back(
+      format_line("Grid buckets:", format_bytes(bucket_bytes)) +
+      U" (" +
+      decode(std::to_string(buckets)) +
+      U" buckets)"
+    );
+    std::snprintf(
+      buffer,
+      sizeof(buffer),
+      "%.2f",
+      buckets > 0 ? static_cast<double>(grid.size()) / buckets : 0.0
+    );
+    result.push_back(format_line("Load factor:", decode(buffer)));
+    if (cells > 0)
+    {
+      result.push_back(
+        format_line(
+          "Bytes per cell:",
+          (node_bytes + bucket_bytes + string_bytes) / cells
+        )
+      );
+    }
+    result.push_back(
+      format_line("String payload:", format_bytes(string_bytes))
+    );
+    result.push_back(format_line("Error messages:", format_bytes(error_bytes)));
+    result.push_back(
+      format_line("Formula results:", format_bytes(result_bytes)) +
+      U" (" +
+      decode(std::to_string(sheet.results.size())) +
+      U" results)"
+    );
+    result.push_back(
+      format_line("Recovery log:", format_bytes(recovery_bytes))
+    );
+    result.push_back(format_line("Row hashes:", format_bytes(hash_bytes)));
+    result.push_back(
+      format_line("Registers:", format_bytes(registers.bytes)) +
+      U" (" +
+      decode(std::to_string(registers.registers)) +
+      U" registers, " +
+      decode(std::to_string(registers.cells)) +
+      U" cells)"
+    );
+    result.push_back(
+      format_line("Undo history:", format_bytes(sheet.journal.size)) +
+      U" (" +
+      decode(std::to_string(sheet.journal.undo_stack.size())) +
+      U" undo, " +
+      decode(std::to_string(sheet.journal.redo_stack.size())) +
+      U" redo)"
+    );
+    result.push_back(
+      format_line(
+        "Total:",
+        format_bytes(
+          sizeof(struct sheet) +
+          node_bytes +
+          bucket_bytes +
+          string_bytes +
+          error_bytes +
+          result_bytes +
+          recovery_bytes +
+          hash_bytes +
+          registers.bytes +
+          sheet.journal.size
+        )
+      )
+    );
+
+    return result;
+  }
+}
@@ -59,4 +59,98 @@ namespace utils
 
     return input;
   }
+
+  // Decodes UTF-8 into an existing buffer so that its storage can be reused
+  // between calls. Malformed sequences are replaced with U+FFFD.
+  void
+  decode_utf8(const std::string_view& input, std::u32string& output)
+  {
+    const auto length = input.length();
+    std::size_t i = 0;
+
+    output.clear();
+    while (i < length)
+    {
+      const auto c = static_cast<unsigned char>(input[i]);
+      char32_t result;
+      std::size_t size;
+
+      if (c < 0x80)
+      {
+        output.append(1, c);
+        ++i;
+        continue;
+      }
+      else if ((c & 0xe0) == 0xc0)
+      {
+        result = c & 0x1f;
+        size = 2;
+      }
+      else if ((c & 0xf0) == 0xe0)
+      {
+        result = c & 0x0f;
+        size = 3;
+      }
+      else if ((c & 0xf8) == 0xf0)
+      {
+        result = c & 0x07;
+        size = 4;
+      } else {
+        output.append(1, 0xfffd);
+        ++i;
+        continue;
+      }
+      if (i + size > length)
+      {
+        output.append(1, 0xfffd);
+        break;
+      }
+      for (std::size_t j = 1; j < size; ++j)
+      {
+        const auto next = static_cast<unsigned char>(input[i + j]);
+
+        if ((next & 0xc0) != 0x80)
+        {
+          result = 0xfffd;
+          size = j;
+          break;
+        }
+        result = (result << 6) | (next & 0x3f);
+      }
+      output.append(1, result);
+      i += size;
+    }
+  }
+
+  void
+  append_utf8(const std::u32string_view& input, std::string& output)
+  {
+    for (const auto c : input)
+    {
+      if (c < 0x80)
+      {
+        output.append(1, static_cast<char>(c));
+      }
+      else if (c < 0x800)
+      {
+        output.append(1, static_cast<char>(0xc0 | (c >> 6)));
+        output.append(1, static_cast<char>(0x80 | (c & 0x3f)));
+      }
+      else if (c < 0x10000)
+      {
+        output.append(1, static_cast<char>(0xe0 | (c >> 12)));
+        output.append(1, static_cast<char>(0x80 | ((c >> 6) & 0x3f)));
+        output.append(1, static_cast<char>(0x80 | (c & 0x3f)));
+      }
+      else if (c < 0x110000)
+      {
+        output.append(1, static_cast<char>(0xf0 | (c >> 18)));
+        output.append(1, static_cast<char>(0x80 | ((c >> 12) & 0x3f)));
+        output.append(1, static_cast<char>(0x80 | ((c >> 6) & 0x3f)));
+        output.append(1, static_cast<char>(0x80 | (c & 0x3f)));
+      } else {
+        output.append("\xef\xbf\xbd");
+      }
+    }
+  }
 }
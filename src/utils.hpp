@@ -27,6 +27,7 @@
 
 #include <algorithm>
 #include <string>
+#include <string_view>
 
 #include <peelo/unicode/ctype/isspace.hpp>
 
@@ -51,4 +52,11 @@ namespace utils
 
   std::u32string
   trim(const std::u32string& input);
+
+  void
+  decode_utf8(const std::string_view& input, std::u32string& output);
+
+  // Appends UTF-8 encoding of given text to the output.
+  void
+  append_utf8(const std::u32string_view& input, std::string& output);
 }
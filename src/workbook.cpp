@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <peelo/unicode/encoding/utf8.hpp>
+
+#include "./screen.hpp"
+#include "./workbook.hpp"
+
+workbook::workbook()
+  : current(0)
+  , separator(sheet::DEFAULT_SEPARATOR) {}
+
+struct sheet&
+workbook::add(
+  const std::u32string& name,
+  const std::optional<std::filesystem::path>& filename
+)
+{
+  using peelo::unicode::encoding::utf8::decode;
+
+  auto sheet = std::make_unique<struct sheet>();
+  auto unique_name = name;
+  auto& result = *sheet;
+
+  for (int i = 2; find_entry(unique_name); ++i)
+  {
+    unique_name = name + U'-' + decode(std::to_string(i));
+  }
+  sheet->filename = filename;
+  sheet->separator = separator;
+  sheet->filter = filter;
+  sheet->workbook = this;
+  entries.push_back({
+    unique_name,
+    std::move(sheet),
+    !filename,
+    std::nullopt
+  });
+
+  return result;
+}
+
+workbook::entry*
+workbook::find_entry(const std::u32string& name)
+{
+  for (auto& entry : entries)
+  {
+    if (!entry.name.compare(name))
+    {
+      return &entry;
+    }
+  }
+
+  return nullptr;
+}
+
+struct sheet*
+workbook::find(const std::u32string& name)
+{
+  if (const auto entry = find_entry(name))
+  {
+    if (!entry->loaded)
+    {
+      load(*entry);
+    }
+
+    // Sheets which failed to load are empty or only partially loaded, so
+    // they are never referenced.
+    return entry->error ? nullptr : entry->sheet.get();
+  }
+
+  return nullptr;
+}
+
+std::optional<std::u32string>
+workbook::load(entry& entry, bool progressive)
+{
+  using peelo::unicode::encoding::utf8::decode;
+
+  auto& sheet = *entry.sheet;
+
+  // Sheets are loaded only once, even when loading fails, so that a broken
+  // file is not re-read every time it is referenced.
+  entry.loaded = true;
+  entry.error.reset();
+  if (sheet.filename)
+  {
+    if (
+      const auto error = sheet.load(
+        *sheet.filename,
+        sheet.separator,
+        progressive
+      )
+    )
+    {
+      entry.error = error;
+
+      return error;
+    }
+    if (const auto count = sheet.recover())
+    {
+      message = U"Recovered " +
+        decode(std::to_string(count)) +
+        U" unsaved changes.";
+    }
+  }
+
+  return std::nullopt;
+}
+
+std::optional<std::u32string>
+workbook::select(const std::u32string& name)
+{
+  for (std::size_t i = 0; i < entries.size(); ++i)
+  {
+    auto& entry = entries[i];
+
+    if (entry.name.compare(name))
+    {
+      continue;
+    }
+    if (!entry.loaded)
+    {
+      if (const auto error = load(entry))
+      {
+        return error;
+      }
+    }
+    current = i;
+
+    return std::nullopt;
+  }
+
+  return U"No such sheet: " + name;
+}
+
+bool
+workbook::is_modified() const
+{
+  for (const auto& entry : entries)
+  {
+    if (entry.sheet->modified)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+unsigned long
+workbook::get_generation() const
+{
+  unsigned long result = 0;
+
+  for (const auto& entry : entries)
+  {
+    result += entry.sheet->version;
+  }
+
+  return result;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2026, Rauli Laine
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "./sheet.hpp"
+
+struct workbook
+{
+  struct entry
+  {
+    std::u32string name;
+    std::unique_ptr<struct sheet> sheet;
+    bool loaded;
+    // Error from loading the sheet, which keeps it from being referenced.
+    std::optional<std::u32string> error;
+  };
+
+  std::vector<entry> entries;
+  std::size_t current;
+  char separator;
+  // Part of their files loaded into the sheets.
+  struct load_filter filter;
+
+  explicit workbook();
+
+  inline entry&
+  get_current()
+  {
+    return entries[current];
+  }
+
+  struct sheet&
+  add(
+    const std::u32string& name,
+    const std::optional<std::filesystem::path>& filename = std::nullopt
+  );
+
+  entry*
+  find_entry(const std::u32string& name);
+
+  struct sheet*
+  find(const std::u32string& name);
+
+  std::optional<std::u32string>
+  load(entry& entry, bool progressive = false);
+
+  std::optional<std::u32string>
+  select(const std::u32string& name);
+
+  bool
+  is_modified() const;
+
+  unsigned long
+  get_generation() const;
+};